@@ -25,17 +25,78 @@
 #include <string.h>
 
 BSP_OSPI_NOR_Init_t Flash;
+static uint32_t     MemoryMapped;       /* OSPI memory in memory-mapped mode */
+static uint32_t     MemoryBusy;         /* Erase / program issued, completion not yet polled */
 
   
 /* Private functions ---------------------------------------------------------*/
+static int OSPI_Indirect (void);
+static int OSPI_MemoryMapped (void);
+static int OSPI_WaitReady (void);
+
 /** @defgroup STM32U599J_DK_OSPI_Exported_Functions Exported Functions
 * @{
 */
 
+/* Debug Exception and Monitor Control Register (DEMCR) */
+#define TICK_DEMCR          (*((volatile uint32_t *)0xE000EDFCU))
+#define TICK_DEMCR_TRCENA   (1UL << 24)
+
+/**
+* @brief  Override default HAL_GetTick function.
+*         Millisecond tick derived from the free-running DWT cycle counter,
+*         interrupts are disabled in the loader so SysTick cannot be used.
+* @retval tick value
+*/
+uint32_t HAL_GetTick(void)
+{
+  static uint32_t ticks  = 0U;
+  static uint32_t cycLst = 0U;
+  static uint32_t cycRem = 0U;
+         uint32_t cycNow, cycMs;
+
+  if ((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) == 0U) {
+    TICK_DEMCR  |= TICK_DEMCR_TRCENA;
+    DWT->CYCCNT  = 0U;
+    DWT->CTRL   |= DWT_CTRL_CYCCNTENA_Msk;
+    cycLst       = 0U;
+  }
+
+  /* Accumulate elapsed cycles (wrap-safe), SystemCoreClock may change */
+  cycNow  = DWT->CYCCNT;
+  cycRem += cycNow - cycLst;
+  cycLst  = cycNow;
+
+  cycMs = SystemCoreClock / 1000U;
+  if (cycMs == 0U) {
+    cycMs = 1U;
+  }
+  ticks  += cycRem / cycMs;
+  cycRem %= cycMs;
+
+  return ticks;
+}
+
+/**
+* @brief  Override default HAL_Delay function.
+* @param  Delay  delay in milliseconds
+* @retval None
+*/
 void HAL_Delay(uint32_t Delay)
 {
-  int i=0;
-  for (i=0; i<0x1000; i++);
+  uint32_t tickstart = HAL_GetTick();
+  uint32_t wait = Delay;
+
+  /* Add a period to guaranty minimum wait */
+  if (wait < HAL_MAX_DELAY)
+  {
+    wait += (uint32_t)(HAL_TICK_FREQ_DEFAULT);
+  }
+
+  while((HAL_GetTick() - tickstart) < wait)
+  {
+    __NOP();
+  }
 }
 
 
@@ -59,23 +120,115 @@ int Init_OSPI()
   SystemInit();  
   HAL_Init();  
   		
-  Flash.InterfaceMode = BSP_OSPI_NOR_SPI_MODE; 
-  Flash.TransferRate  = BSP_OSPI_NOR_STR_TRANSFER; 
+  Flash.InterfaceMode = BSP_OSPI_NOR_OPI_MODE; 
+  Flash.TransferRate  = OSPI_NOR_TRANSFER_RATE; 
 	
 /* Configure the system clock  */
   SystemClock_Config();
   
- /* Initialaize OSPI */   
-    if( BSP_OSPI_NOR_Init(0, &Flash)!=0)
-			return 0;
+ /* Initialaize OSPI (once per session) */   
+  MemoryMapped = 0U;
+  MemoryBusy   = 0U;
+  if (BSP_OSPI_NOR_Init(0, &Flash) != 0)
+    return 0;
+
+  return OSPI_MemoryMapped();
+}
+
+/*******************************************************************************
+* @brief  End of session, leave the OSPI memory in memory-mapped mode.
+* @param  None
+* @retval  1      : Operation succeeded
+* @retval  0      : Operation failed
+*******************************************************************************/
+int UnInit_OSPI()
+{
+  return OSPI_MemoryMapped();
+}
+
+/**
+* @brief  Complete pending erase / program and enter memory-mapped mode for read back.
+* @param  None
+* @retval  1      : Operation succeeded
+* @retval  0      : Operation failed
+*/
+int MemoryMapped_OSPI()
+{
+  return OSPI_MemoryMapped();
+}
+
+/*******************************************************************************
+* @brief  Switch OSPI to indirect mode (required for erase / program).
+* @param  None
+* @retval  1      : Operation succeeded
+* @retval  0      : Operation failed
+*******************************************************************************/
+static int OSPI_Indirect (void)
+{
+  if (OSPI_WaitReady() == 0)
+    return 0;
+
+  if (MemoryMapped != 0U)
+  {
+    if (BSP_OSPI_NOR_DisableMemoryMappedMode(0) != 0)
+      return 0;
+    MemoryMapped = 0U;
+  }
 
-    if( BSP_OSPI_NOR_EnableMemoryMappedMode(0)!=0)
-			return 0;
- 
-  
   return 1;
 }
 
+/*******************************************************************************
+* @brief  Switch OSPI to memory-mapped mode (required for read / verify).
+* @param  None
+* @retval  1      : Operation succeeded
+* @retval  0      : Operation failed
+*******************************************************************************/
+static int OSPI_MemoryMapped (void)
+{
+  if (OSPI_WaitReady() == 0)
+    return 0;
+
+  if (MemoryMapped == 0U)
+  {
+    if (BSP_OSPI_NOR_EnableMemoryMappedMode(0) != 0)
+      return 0;
+    MemoryMapped = 1U;
+  }
+
+  return 1;
+}
+
+/**
+* @brief  Wait for the completion of a pending erase or page program.
+* @param  None
+* @retval  1      : Operation succeeded
+* @retval  0      : Operation failed (P_FAIL / E_FAIL, status read error or timeout)
+*/
+static int OSPI_WaitReady (void)
+{
+  uint32_t tickstart;
+  int32_t  status;
+
+  if (MemoryBusy == 0U)
+    return 1;
+
+  /* Reads current status of the OSPI memory until it is ready or reports an error */
+  tickstart = HAL_GetTick();
+  do
+  {
+    status = BSP_OSPI_NOR_GetStatus(0);
+    if (status == BSP_ERROR_NONE)
+    {
+      MemoryBusy = 0U;
+      return 1;
+    }
+  } while ((status == BSP_ERROR_BUSY) && ((HAL_GetTick() - tickstart) < TIMEOUT));
+
+  /* Failure stays pending: every later operation reports it until Init */
+  return 0;
+}
+
 /*******************************************************************************
 * @brief   masserase memory.
 * @retval  1      : Operation succeeded
@@ -83,16 +236,22 @@ int Init_OSPI()
 *******************************************************************************/
 
 int MassErase (uint32_t Parallelism ){
+  uint32_t tickstart;
+  int32_t  status;
 
-   if(BSP_OSPI_NOR_DeInit(0)!=0)
-		return 0;  
-  if( BSP_OSPI_NOR_Init(0, &Flash)!=0)
-			return 0;
+  if (OSPI_Indirect() == 0)
+    return 0;
   if(BSP_OSPI_NOR_Erase_Chip(0)!=0)
 		return 0;
-  while (BSP_OSPI_NOR_GetStatus(0)!=0);
- 
-	return 1;
+
+  /* Reads current status of the OSPI memory, bulk erase takes up to MX25LM51245G_BULK_ERASE_MAX_TIME */
+  tickstart = HAL_GetTick();
+  do
+  {
+    status = BSP_OSPI_NOR_GetStatus(0);
+  } while ((status == BSP_ERROR_BUSY) && ((HAL_GetTick() - tickstart) < MX25LM51245G_BULK_ERASE_MAX_TIME));
+
+  return (status == BSP_ERROR_NONE) ? 1 : 0;
 }
 
 /*******************************************************************************
@@ -105,14 +264,42 @@ int MassErase (uint32_t Parallelism ){
 *******************************************************************************/
 int Write (uint32_t Address, uint32_t Size, uint8_t* buffer)
 {  
+  uint8_t pair[2];
+
   Address = Address & 0x0fffffff;
 
-  if(BSP_OSPI_NOR_DeInit(0)!=0)
-		return 0;    
+  if (OSPI_Indirect() == 0)
+    return 0;
+
+  /* The last page is completed by the next operation */
+  MemoryBusy = 1U;
 
-  if( BSP_OSPI_NOR_Init(0, &Flash)!=0)
-			return 0;
-  if(BSP_OSPI_NOR_Write(0,buffer,Address, Size)!=0)
+  if (Flash.TransferRate == BSP_OSPI_NOR_DTR_TRANSFER)
+  {
+    /* DTR transfers move byte pairs: pad odd start / end with erased value */
+    if ((Address & 1U) != 0U)
+    {
+      pair[0] = 0xFF;
+      pair[1] = *buffer;
+      if (BSP_OSPI_NOR_Write_Start(0, pair, Address - 1U, 2U) != 0)
+        return 0;
+      Address++;
+      buffer++;
+      Size--;
+    }
+    if ((Size & 1U) != 0U)
+    {
+      pair[0] = buffer[Size - 1U];
+      pair[1] = 0xFF;
+      if (BSP_OSPI_NOR_Write_Start(0, pair, Address + Size - 1U, 2U) != 0)
+        return 0;
+      Size--;
+    }
+    if (Size == 0U)
+      return 1;
+  }
+
+  if(BSP_OSPI_NOR_Write_Start(0,buffer,Address, Size)!=0)
 		return 0;
 
   return 1;
@@ -126,31 +313,49 @@ int Write (uint32_t Address, uint32_t Size, uint8_t* buffer)
 *******************************************************************************/
 int SectorErase (uint32_t EraseStartAddress ,uint32_t EraseEndAddress)
 {
-  uint32_t BlockAddr;
-  EraseStartAddress &= 0x0FFFFFFF;  
+  uint32_t BlockSize;
+  BSP_OSPI_NOR_Erase_t BlockType;
+
+  EraseStartAddress &= 0x0FFFFFFF;
   EraseEndAddress   &= 0x0FFFFFFF;
-  EraseStartAddress = EraseStartAddress -  EraseStartAddress % 0x10000;
+  EraseStartAddress = EraseStartAddress -  EraseStartAddress % MX25LM51245G_SUBSECTOR_4K;
 
-  if(BSP_OSPI_NOR_DeInit(0)!=0)
-		return 0;  
-	
-  if( BSP_OSPI_NOR_Init(0, &Flash)!=0)
-			return 0;
+  /* Whole memory requested: chip erase is faster than erasing block by block */
+  if ((EraseStartAddress == 0U) && (EraseEndAddress >= MX25LM51245G_FLASH_SIZE))
+    return MassErase(0);
+
+  if (OSPI_Indirect() == 0)
+    return 0;
 
-  while (EraseEndAddress >EraseStartAddress)
+  while (EraseEndAddress > EraseStartAddress)
   {
-    BlockAddr = EraseStartAddress;   
-    if(BSP_OSPI_NOR_Erase_Block(0,BlockAddr,  MX25LM51245G_ERASE_64K)!=0)
-			return 0;
-    while (BSP_OSPI_NOR_GetStatus(0)!=0);  
-    EraseStartAddress+=0x10000;		
-			
-  } 
-	if(BSP_OSPI_NOR_EnableMemoryMappedMode(0)!=0)
-				return 0;
+    /* Use a 64KB block erase where an aligned block fits in the range, 4KB subsector erase otherwise */
+    if (((EraseStartAddress % MX25LM51245G_SECTOR_64K) == 0U) &&
+        ((EraseEndAddress - EraseStartAddress) >= MX25LM51245G_SECTOR_64K))
+    {
+      BlockType = BSP_OSPI_NOR_ERASE_64K;
+      BlockSize = MX25LM51245G_SECTOR_64K;
+    }
+    else
+    {
+      BlockType = BSP_OSPI_NOR_ERASE_4K;
+      BlockSize = MX25LM51245G_SUBSECTOR_4K;
+    }
 
-	
-  return 1;	
+    /* Erases the specified block of the OSPI memory, the last erase is
+       left running and is completed by the next operation (erase-ahead).
+       E_FAIL of a running erase fails OSPI_WaitReady of the operation that
+       completes it: this loop, OSPI_Indirect or OSPI_MemoryMapped */
+    if (OSPI_WaitReady() == 0)
+      return 0;
+    if (BSP_OSPI_NOR_Erase_Block(0, EraseStartAddress, BlockType) != 0)
+      return 0;
+    MemoryBusy = 1U;
+
+    EraseStartAddress += BlockSize;
+  }
+
+  return 1;
 }
 
 /**
@@ -50,6 +50,46 @@
   * @{
   */
 
+/** @defgroup MX25LM51245G_Private_Functions MX25LM51245G Private Functions
+  * @{
+  */
+
+/**
+  * @brief  Transmit the data phase of a program command (added by ARM).
+  *         Word aligned data is streamed by DMA when a DMA channel is linked
+  *         to the OSPI handle, otherwise the polled FIFO transfer is used.
+  * @param  Ctx Component object pointer
+  * @param  pData Pointer to data to be written
+  * @param  Size Size of data to write
+  * @retval OSPI memory status
+  */
+static int32_t MX25LM51245G_TransmitData(OSPI_HandleTypeDef *Ctx, uint8_t *pData, uint32_t Size)
+{
+  if ((Ctx->hdma != NULL) && ((((uint32_t)pData) & 3U) == 0U) && ((Size & 3U) == 0U))
+  {
+    /* DMA transfer, completion polled (interrupts are disabled) */
+    if (HAL_OSPI_Transmit_DMA(Ctx, pData) != HAL_OK)
+    {
+      return MX25LM51245G_ERROR;
+    }
+
+    if (HAL_OSPI_PollForTransfer_DMA(Ctx, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+    {
+      return MX25LM51245G_ERROR;
+    }
+  }
+  else if (HAL_OSPI_Transmit(Ctx, pData, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+  {
+    return MX25LM51245G_ERROR;
+  }
+
+  return MX25LM51245G_OK;
+}
+
+/**
+  * @}
+  */
+
 /** @defgroup MX25LM51245G_Exported_Functions MX25LM51245G Exported Functions
   * @{
   */
@@ -302,7 +342,7 @@ int32_t MX25LM51245G_PageProgram(OSPI_HandleTypeDef *Ctx, MX25LM51245G_Interface
   }
 
   /* Transmission of the data */
-  if (HAL_OSPI_Transmit(Ctx, pData, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+  if (MX25LM51245G_TransmitData(Ctx, pData, Size) != MX25LM51245G_OK)
   {
     return MX25LM51245G_ERROR;
   }
@@ -354,7 +394,7 @@ int32_t MX25LM51245G_PageProgramDTR(OSPI_HandleTypeDef *Ctx, uint8_t *pData, uin
   }
 
   /* Transmission of the data */
-  if (HAL_OSPI_Transmit(Ctx, pData, HAL_OSPI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+  if (MX25LM51245G_TransmitData(Ctx, pData, Size) != MX25LM51245G_OK)
   {
     return MX25LM51245G_ERROR;
   }
@@ -123,6 +123,23 @@ typedef struct
 #define OSPI_FORCE_RESET()                __HAL_RCC_OSPI1_FORCE_RESET()
 #define OSPI_RELEASE_RESET()              __HAL_RCC_OSPI1_RELEASE_RESET()
 
+/* Definition for OSPI DMA resources (page programming) */
+#define OSPI_DMA_CLK_ENABLE()             __HAL_RCC_GPDMA_CLK_ENABLE()
+#define OSPI_DMA_INSTANCE                 GPDMA_Channel0
+#define OSPI_DMA_REQUEST                  GPDMA_REQUEST_OCTOSPI1
+
+/* OctoSPI kernel clock PLL2Q = MSI 4MHz * PLL2N / PLL2Q, per clock profile */
+#if   (OSPI_NOR_CLK_PROFILE == 3U)
+#define OSPI_KERCLK_PLL2N                 100U  /* 200 MHz */
+#define OSPI_KERCLK_PLL2Q                 2U
+#elif (OSPI_NOR_CLK_PROFILE == 2U)
+#define OSPI_KERCLK_PLL2N                 100U  /* 133 MHz */
+#define OSPI_KERCLK_PLL2Q                 3U
+#elif (OSPI_NOR_CLK_PROFILE == 1U)
+#define OSPI_KERCLK_PLL2N                 50U   /* 100 MHz */
+#define OSPI_KERCLK_PLL2Q                 2U
+#endif
+
 /* Definition for OSPI Pins */
 /* OSPI_CLK */
 #define OSPI_CLK_PIN                      GPIO_PIN_10
@@ -222,6 +239,7 @@ int32_t BSP_OSPI_NOR_RegisterDefaultMspCallbacks (uint32_t Instance);
 #endif /* (USE_HAL_OSPI_REGISTER_CALLBACKS == 1) */
 int32_t BSP_OSPI_NOR_Read                        (uint32_t Instance, uint8_t* pData, uint32_t ReadAddr, uint32_t Size);
 int32_t BSP_OSPI_NOR_Write                       (uint32_t Instance, uint8_t* pData, uint32_t WriteAddr, uint32_t Size);
+int32_t BSP_OSPI_NOR_Write_Start                 (uint32_t Instance, uint8_t* pData, uint32_t WriteAddr, uint32_t Size);
 int32_t BSP_OSPI_NOR_Erase_Block                 (uint32_t Instance, uint32_t BlockAddress, BSP_OSPI_NOR_Erase_t BlockSize);
 int32_t BSP_OSPI_NOR_Erase_Chip                  (uint32_t Instance);
 int32_t BSP_OSPI_NOR_GetStatus                   (uint32_t Instance);
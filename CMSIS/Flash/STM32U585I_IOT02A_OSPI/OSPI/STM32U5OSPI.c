@@ -23,24 +23,51 @@
 
 
 BSP_OSPI_NOR_Init_t Flash;
+static uint32_t     MemoryMapped;       /* OSPI memory in memory-mapped mode */
+static uint32_t     MemoryBusy;         /* Erase / program issued, completion not yet polled */
 
 /* Private functions ---------------------------------------------------------*/
+static int OSPI_Indirect (void);
+static int OSPI_MemoryMapped (void);
+static int OSPI_WaitReady (void);
+
+
+/* Debug Exception and Monitor Control Register (DEMCR) */
+#define TICK_DEMCR          (*((volatile uint32_t *)0xE000EDFCU))
+#define TICK_DEMCR_TRCENA   (1UL << 24)
 
 /**
   * Override default HAL_GetTick function (added by ARM)
+  * Millisecond tick derived from the free-running DWT cycle counter,
+  * interrupts are disabled in the loader so SysTick cannot be used.
   */
 uint32_t HAL_GetTick (void)
 {
-  static uint32_t ticks = 0U;
-         uint32_t i;
-
-  /* If Kernel is not running wait approximately 1 ms then increment
-     and return auxiliary tick counter value */
-  for (i = (SystemCoreClock >> 14U); i > 0U; i--) {
-    __NOP(); __NOP(); __NOP(); __NOP(); __NOP();
-//  __NOP(); __NOP(); __NOP(); __NOP(); __NOP();
+  static uint32_t ticks  = 0U;
+  static uint32_t cycLst = 0U;
+  static uint32_t cycRem = 0U;
+         uint32_t cycNow, cycMs;
+
+  if ((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) == 0U) {
+    TICK_DEMCR  |= TICK_DEMCR_TRCENA;
+    DWT->CYCCNT  = 0U;
+    DWT->CTRL   |= DWT_CTRL_CYCCNTENA_Msk;
+    cycLst       = 0U;
+  }
+
+  /* Accumulate elapsed cycles (wrap-safe), SystemCoreClock may change */
+  cycNow  = DWT->CYCCNT;
+  cycRem += cycNow - cycLst;
+  cycLst  = cycNow;
+
+  cycMs = SystemCoreClock / 1000U;
+  if (cycMs == 0U) {
+    cycMs = 1U;
   }
-  return ++ticks;
+  ticks  += cycRem / cycMs;
+  cycRem %= cycMs;
+
+  return ticks;
 }
 
 /**
@@ -91,22 +118,115 @@ int Init_OSPI()
   SystemInit();
 
   Flash.InterfaceMode = BSP_OSPI_NOR_OPI_MODE;
-  Flash.TransferRate  = BSP_OSPI_NOR_STR_TRANSFER;
+  Flash.TransferRate  = OSPI_NOR_TRANSFER_RATE;
 
   /* Configure the system clock  */
   SystemClock_Config();
 
-  /* Initialaize OSPI */
+  /* Initialaize OSPI (once per session) */
+  MemoryMapped = 0U;
+  MemoryBusy   = 0U;
   if (BSP_OSPI_NOR_Init(0, &Flash) !=0)
     return 0;
 
   /* Configure the OSPI in memory-mapped mode */
-  if (BSP_OSPI_NOR_EnableMemoryMappedMode(0) !=0)
+  return OSPI_MemoryMapped();
+}
+
+/**
+  * @brief  End of session, leave the OSPI memory in memory-mapped mode.
+  * @param  None
+  * @retval  1      : Operation succeeded
+  * @retval  0      : Operation failed
+  */
+int UnInit_OSPI()
+{
+  return OSPI_MemoryMapped();
+}
+
+/**
+  * @brief  Complete pending erase / program and enter memory-mapped mode for read back.
+  * @param  None
+  * @retval  1      : Operation succeeded
+  * @retval  0      : Operation failed
+  */
+int MemoryMapped_OSPI()
+{
+  return OSPI_MemoryMapped();
+}
+
+/**
+  * @brief  Switch OSPI to indirect mode (required for erase / program).
+  * @param  None
+  * @retval  1      : Operation succeeded
+  * @retval  0      : Operation failed
+  */
+static int OSPI_Indirect (void)
+{
+  if (OSPI_WaitReady() == 0)
     return 0;
 
+  if (MemoryMapped != 0U)
+  {
+    if (BSP_OSPI_NOR_DisableMemoryMappedMode(0) !=0)
+      return 0;
+    MemoryMapped = 0U;
+  }
+
   return 1;
 }
 
+/**
+  * @brief  Switch OSPI to memory-mapped mode (required for read / verify).
+  * @param  None
+  * @retval  1      : Operation succeeded
+  * @retval  0      : Operation failed
+  */
+static int OSPI_MemoryMapped (void)
+{
+  if (OSPI_WaitReady() == 0)
+    return 0;
+
+  if (MemoryMapped == 0U)
+  {
+    if (BSP_OSPI_NOR_EnableMemoryMappedMode(0) !=0)
+      return 0;
+    MemoryMapped = 1U;
+  }
+
+  return 1;
+}
+
+/**
+  * @brief  Wait for the completion of a pending erase or page program.
+  * @param  None
+  * @retval  1      : Operation succeeded
+  * @retval  0      : Operation failed (P_FAIL / E_FAIL, status read error or timeout)
+  */
+static int OSPI_WaitReady (void)
+{
+  uint32_t tickstart;
+  int32_t  status;
+
+  if (MemoryBusy == 0U)
+    return 1;
+
+  /* Reads current status of the OSPI memory until it is ready or reports an error */
+  tickstart = HAL_GetTick();
+  do
+  {
+    status = BSP_OSPI_NOR_GetStatus(0);
+    if (status == BSP_ERROR_NONE)
+    {
+      MemoryBusy = 0U;
+      return 1;
+    }
+  } while ((status == BSP_ERROR_BUSY) && ((HAL_GetTick() - tickstart) < TIMEOUT));
+
+  /* Failure stays pending: every later operation reports it until Init */
+  return 0;
+}
+
 /**
   * @brief   masserase memory.
   * @retval  1      : Operation succeeded
@@ -114,21 +234,24 @@ int Init_OSPI()
   */
 int MassErase (void)
 {
-  /* Initialize OSPI */
-  if (BSP_OSPI_NOR_DeInit(0) !=0)
-    return 0;
+  uint32_t tickstart;
+  int32_t  status;
 
-  if (BSP_OSPI_NOR_Init(0, &Flash) !=0)
+  if (OSPI_Indirect() == 0)
     return 0;
 
   /* Erases the entire OSPI memory */
   if (BSP_OSPI_NOR_Erase_Chip(0) !=0)
     return 0;
 
-  /* Reads current status of the OSPI memory */
-  while (BSP_OSPI_NOR_GetStatus(0) !=0);
+  /* Reads current status of the OSPI memory, bulk erase takes up to MX25LM51245G_BULK_ERASE_MAX_TIME */
+  tickstart = HAL_GetTick();
+  do
+  {
+    status = BSP_OSPI_NOR_GetStatus(0);
+  } while ((status == BSP_ERROR_BUSY) && ((HAL_GetTick() - tickstart) < MX25LM51245G_BULK_ERASE_MAX_TIME));
 
-  return 1;
+  return (status == BSP_ERROR_NONE) ? 1 : 0;
 }
 
 /**
@@ -141,17 +264,43 @@ int MassErase (void)
   */
 int Write (uint32_t Address, uint32_t Size, uint8_t* buffer)
 {
+  uint8_t pair[2];
+
   Address = Address & 0x0fffffff;
 
-  /* Initialaize OSPI */
-  if (BSP_OSPI_NOR_DeInit(0) !=0)
+  if (OSPI_Indirect() == 0)
     return 0;
 
-  if (BSP_OSPI_NOR_Init(0, &Flash) !=0)
-    return 0;
+  /* The last page is completed by the next operation */
+  MemoryBusy = 1U;
+
+  if (Flash.TransferRate == BSP_OSPI_NOR_DTR_TRANSFER)
+  {
+    /* DTR transfers move byte pairs: pad odd start / end with erased value */
+    if ((Address & 1U) != 0U)
+    {
+      pair[0] = 0xFF;
+      pair[1] = *buffer;
+      if (BSP_OSPI_NOR_Write_Start(0, pair, Address - 1U, 2U) !=0)
+        return 0;
+      Address++;
+      buffer++;
+      Size--;
+    }
+    if ((Size & 1U) != 0U)
+    {
+      pair[0] = buffer[Size - 1U];
+      pair[1] = 0xFF;
+      if (BSP_OSPI_NOR_Write_Start(0, pair, Address + Size - 1U, 2U) !=0)
+        return 0;
+      Size--;
+    }
+    if (Size == 0U)
+      return 1;
+  }
 
   /* Writes data to the OSPI memory */
-  if (BSP_OSPI_NOR_Write(0, buffer, Address, Size) !=0)
+  if (BSP_OSPI_NOR_Write_Start(0, buffer, Address, Size) !=0)
     return 0;
 
   return 1;
@@ -167,35 +316,48 @@ int Write (uint32_t Address, uint32_t Size, uint8_t* buffer)
   */
 int SectorErase (uint32_t EraseStartAddress ,uint32_t EraseEndAddress)
 {
-  uint32_t BlockAddr;
+  uint32_t BlockSize;
+  BSP_OSPI_NOR_Erase_t BlockType;
 
   EraseStartAddress &= 0x0FFFFFFF;
   EraseEndAddress   &= 0x0FFFFFFF;
-  EraseStartAddress = EraseStartAddress -  EraseStartAddress % 0x10000;
+  EraseStartAddress = EraseStartAddress -  EraseStartAddress % MX25LM51245G_SUBSECTOR_4K;
 
-  /* Initialaize OSPI */
-  if (BSP_OSPI_NOR_DeInit(0) !=0)
-    return 0;
+  /* Whole memory requested: chip erase is faster than erasing block by block */
+  if ((EraseStartAddress == 0U) && (EraseEndAddress >= MX25LM51245G_FLASH_SIZE))
+    return MassErase();
 
-  if (BSP_OSPI_NOR_Init(0, &Flash) !=0)
+  if (OSPI_Indirect() == 0)
     return 0;
 
   while (EraseEndAddress > EraseStartAddress)
   {
-    BlockAddr = EraseStartAddress;
-    /* Erases the specified block of the OSPI memory */
-    if (BSP_OSPI_NOR_Erase_Block(0, BlockAddr, MX25LM51245G_ERASE_64K) !=0)
+    /* Use a 64KB block erase where an aligned block fits in the range, 4KB subsector erase otherwise */
+    if (((EraseStartAddress % MX25LM51245G_SECTOR_64K) == 0U) &&
+        ((EraseEndAddress - EraseStartAddress) >= MX25LM51245G_SECTOR_64K))
+    {
+      BlockType = BSP_OSPI_NOR_ERASE_64K;
+      BlockSize = MX25LM51245G_SECTOR_64K;
+    }
+    else
+    {
+      BlockType = BSP_OSPI_NOR_ERASE_4K;
+      BlockSize = MX25LM51245G_SUBSECTOR_4K;
+    }
+
+    /* Erases the specified block of the OSPI memory, the last erase is
+       left running and is completed by the next operation (erase-ahead).
+       E_FAIL of a running erase fails OSPI_WaitReady of the operation that
+       completes it: this loop, OSPI_Indirect or OSPI_MemoryMapped */
+    if (OSPI_WaitReady() == 0)
       return 0;
+    if (BSP_OSPI_NOR_Erase_Block(0, EraseStartAddress, BlockType) !=0)
+      return 0;
+    MemoryBusy = 1U;
 
-    /* Reads current status of the OSPI memory */
-    while (BSP_OSPI_NOR_GetStatus(0) !=0);
-
-    EraseStartAddress+=0x10000;
+    EraseStartAddress += BlockSize;
   }
 
-  if (BSP_OSPI_NOR_EnableMemoryMappedMode(0) !=0)
-    return 0;
-
   return 1;
 }
 
@@ -152,6 +152,23 @@ typedef struct
 #define OSPI_NOR_FORCE_RESET()                __HAL_RCC_OSPI2_FORCE_RESET()
 #define OSPI_NOR_RELEASE_RESET()              __HAL_RCC_OSPI2_RELEASE_RESET()
 
+/* Definition for OSPI DMA resources (page programming) */
+#define OSPI_NOR_DMA_CLK_ENABLE()             __HAL_RCC_GPDMA1_CLK_ENABLE()
+#define OSPI_NOR_DMA_INSTANCE                 GPDMA1_Channel0
+#define OSPI_NOR_DMA_REQUEST                  GPDMA1_REQUEST_OCTOSPI2
+
+/* OctoSPI kernel clock PLL2Q = MSI 4MHz * PLL2N / PLL2Q, per clock profile */
+#if   (OSPI_NOR_CLK_PROFILE == 3U)
+#define OSPI_NOR_KERCLK_PLL2N                 100U  /* 200 MHz */
+#define OSPI_NOR_KERCLK_PLL2Q                 2U
+#elif (OSPI_NOR_CLK_PROFILE == 2U)
+#define OSPI_NOR_KERCLK_PLL2N                 100U  /* 133 MHz */
+#define OSPI_NOR_KERCLK_PLL2Q                 3U
+#elif (OSPI_NOR_CLK_PROFILE == 1U)
+#define OSPI_NOR_KERCLK_PLL2N                 50U   /* 100 MHz */
+#define OSPI_NOR_KERCLK_PLL2Q                 2U
+#endif
+
 /* Definition for OSPI Pins */
 /* OSPI_CLK */
 #define OSPI_NOR_CLK_PIN                      GPIO_PIN_4
@@ -337,6 +354,7 @@ int32_t BSP_OSPI_NOR_RegisterDefaultMspCallbacks(uint32_t Instance);
 #endif /* (USE_HAL_OSPI_REGISTER_CALLBACKS == 1) */
 int32_t BSP_OSPI_NOR_Read(uint32_t Instance, uint8_t *pData, uint32_t ReadAddr, uint32_t Size);
 int32_t BSP_OSPI_NOR_Write(uint32_t Instance, uint8_t *pData, uint32_t WriteAddr, uint32_t Size);
+int32_t BSP_OSPI_NOR_Write_Start(uint32_t Instance, uint8_t *pData, uint32_t WriteAddr, uint32_t Size);
 int32_t BSP_OSPI_NOR_Erase_Block(uint32_t Instance, uint32_t BlockAddress, BSP_OSPI_NOR_Erase_t BlockSize);
 int32_t BSP_OSPI_NOR_Erase_Chip(uint32_t Instance);
 int32_t BSP_OSPI_NOR_GetStatus(uint32_t Instance);
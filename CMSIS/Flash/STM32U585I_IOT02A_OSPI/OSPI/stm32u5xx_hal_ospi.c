@@ -1114,6 +1114,8 @@ HAL_StatusTypeDef HAL_OSPI_Transmit(OSPI_HandleTypeDef *hospi, uint8_t *pData, u
   HAL_StatusTypeDef status;
   uint32_t tickstart = HAL_GetTick();
   __IO uint32_t *data_reg = &hospi->Instance->DR;
+  uint32_t fifo_words;
+  uint32_t words;
 
   /* Check the data pointer allocation */
   if (pData == NULL)
@@ -1134,6 +1136,9 @@ HAL_StatusTypeDef HAL_OSPI_Transmit(OSPI_HandleTypeDef *hospi, uint8_t *pData, u
       /* Configure CR register with functional mode as indirect write */
       MODIFY_REG(hospi->Instance->CR, OCTOSPI_CR_FMODE, OSPI_FUNCTIONAL_MODE_INDIRECT_WRITE);
 
+      /* Number of 32-bit words free in the fifo when the threshold flag is set (added by ARM) */
+      fifo_words = ((READ_BIT(hospi->Instance->CR, OCTOSPI_CR_FTHRES) >> OCTOSPI_CR_FTHRES_Pos) + 1U) >> 2U;
+
       do
       {
         /* Wait till fifo threshold flag is set to send data */
@@ -1144,9 +1149,27 @@ HAL_StatusTypeDef HAL_OSPI_Transmit(OSPI_HandleTypeDef *hospi, uint8_t *pData, u
           break;
         }
 
-        *((__IO uint8_t *)data_reg) = *hospi->pBuffPtr;
-        hospi->pBuffPtr++;
-        hospi->XferCount--;
+        if ((((uint32_t)hospi->pBuffPtr & 3U) == 0U) && (hospi->XferCount >= 4U) && (fifo_words != 0U))
+        {
+          /* Word aligned data: fill the fifo up to the threshold with 32-bit accesses */
+          words = hospi->XferCount >> 2U;
+          if (words > fifo_words)
+          {
+            words = fifo_words;
+          }
+          hospi->XferCount -= (words << 2U);
+          do
+          {
+            *data_reg = *((uint32_t *)hospi->pBuffPtr);
+            hospi->pBuffPtr += 4U;
+          } while (--words != 0U);
+        }
+        else
+        {
+          *((__IO uint8_t *)data_reg) = *hospi->pBuffPtr;
+          hospi->pBuffPtr++;
+          hospi->XferCount--;
+        }
       } while (hospi->XferCount > 0U);
 
       if (status == HAL_OK)
@@ -1190,6 +1213,7 @@ HAL_StatusTypeDef HAL_OSPI_Receive(OSPI_HandleTypeDef *hospi, uint8_t *pData, ui
   __IO uint32_t *data_reg = &hospi->Instance->DR;
   uint32_t addr_reg = hospi->Instance->AR;
   uint32_t ir_reg = hospi->Instance->IR;
+  uint32_t words;
 
   /* Check the data pointer allocation */
   if (pData == NULL)
@@ -1237,9 +1261,29 @@ HAL_StatusTypeDef HAL_OSPI_Receive(OSPI_HandleTypeDef *hospi, uint8_t *pData, ui
           break;
         }
 
-        *hospi->pBuffPtr = *((__IO uint8_t *)data_reg);
-        hospi->pBuffPtr++;
-        hospi->XferCount--;
+        /* Number of complete 32-bit words available in the fifo (added by ARM) */
+        words = READ_BIT(hospi->Instance->SR, OCTOSPI_SR_FLEVEL) >> (OCTOSPI_SR_FLEVEL_Pos + 2U);
+        if (words > (hospi->XferCount >> 2U))
+        {
+          words = hospi->XferCount >> 2U;
+        }
+
+        if ((((uint32_t)hospi->pBuffPtr & 3U) == 0U) && (words != 0U))
+        {
+          /* Word aligned buffer: drain the fifo with 32-bit accesses */
+          hospi->XferCount -= (words << 2U);
+          do
+          {
+            *((uint32_t *)hospi->pBuffPtr) = *data_reg;
+            hospi->pBuffPtr += 4U;
+          } while (--words != 0U);
+        }
+        else
+        {
+          *hospi->pBuffPtr = *((__IO uint8_t *)data_reg);
+          hospi->pBuffPtr++;
+          hospi->XferCount--;
+        }
       } while (hospi->XferCount > 0U);
 
       if (status == HAL_OK)
@@ -1567,6 +1611,60 @@ HAL_StatusTypeDef HAL_OSPI_Transmit_DMA(OSPI_HandleTypeDef *hospi, uint8_t *pDat
   return status;
 }
 
+/**
+  * @brief  Wait in polling mode for the end of a DMA transfer (added by ARM).
+  * @param  hospi   : OSPI handle
+  * @param  Timeout : Timeout duration
+  * @note   Used by the flash loaders which run with interrupts disabled:
+  *         the DMA and OctoSPI completion flags are polled instead of
+  *         being handled by HAL_OSPI_IRQHandler.
+  * @retval HAL status
+  */
+HAL_StatusTypeDef HAL_OSPI_PollForTransfer_DMA(OSPI_HandleTypeDef *hospi, uint32_t Timeout)
+{
+  HAL_StatusTypeDef status;
+  uint32_t tickstart = HAL_GetTick();
+
+  /* Check the state */
+  if ((hospi->State == HAL_OSPI_STATE_BUSY_TX) || (hospi->State == HAL_OSPI_STATE_BUSY_RX))
+  {
+    /* Wait till the DMA channel has moved all data */
+    status = HAL_DMA_PollForTransfer(hospi->hdma, HAL_DMA_FULL_TRANSFER, Timeout);
+
+    if (status == HAL_OK)
+    {
+      /* Wait till transfer complete flag is set to go back in idle state */
+      status = OSPI_WaitFlagStateUntilTimeout(hospi, HAL_OSPI_FLAG_TC, SET, tickstart, Timeout);
+    }
+
+    /* Disable the DMA transfer on the OctoSPI side and the transfer error interrupt */
+    CLEAR_BIT(hospi->Instance->CR, OCTOSPI_CR_DMAEN);
+    __HAL_OSPI_DISABLE_IT(hospi, HAL_OSPI_IT_TE);
+
+    if (status == HAL_OK)
+    {
+      /* Clear transfer complete flag */
+      __HAL_OSPI_CLEAR_FLAG(hospi, HAL_OSPI_FLAG_TC);
+
+      /* Update state */
+      hospi->XferCount = 0U;
+      hospi->State = HAL_OSPI_STATE_READY;
+    }
+    else
+    {
+      hospi->ErrorCode |= HAL_OSPI_ERROR_DMA;
+    }
+  }
+  else
+  {
+    status = HAL_ERROR;
+    hospi->ErrorCode = HAL_OSPI_ERROR_INVALID_SEQUENCE;
+  }
+
+  /* Return function status */
+  return status;
+}
+
 /**
   * @brief  Receive an amount of data in non-blocking mode with DMA.
   * @param  hospi : OSPI handle
@@ -24,7 +24,7 @@ struct FlashDevice const FlashDevice  =  {
    6000,                       // Erase Sector Timeout 6000 mSec
 
 // Specify Size and Address of Sectors
-   0x10000, 0x000000,          // Sector Size  64kB, Sector Num : 1024
+   0x01000, 0x000000,          // Sector Size   4kB, Sector Num : 16384
    SECTOR_END
 };
 
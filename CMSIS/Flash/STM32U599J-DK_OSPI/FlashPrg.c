@@ -11,6 +11,79 @@
 #include "..\FlashOS.h"        
 #include "STM32U5OSPI.h"
 
+#if !defined(DCACHE1) && defined(DCACHE)
+#define DCACHE1     DCACHE     // Older device headers name the data cache DCACHE
+#endif
+
+#ifdef FLASH_MEM
+static uint32_t EraseStart;            // Start of pending sector erase range
+static uint32_t EraseEnd;              // End of pending sector erase range
+static unsigned long BaseAdr;          // Device base address (memory-mapped)
+
+#define CHIP_BLOCK      MX25LM51245G_SECTOR_64K                 // Chip erase scans and erases 64kB blocks
+#define CHIP_BLOCKS     (MX25LM51245G_FLASH_SIZE / CHIP_BLOCK)  // 1024 blocks in the 64MB device
+#define CHIP_PROBE      0x100          // Bytes checked per block before the full scan
+#define CHIP_BLOCK_TYP  220            // Typical 64kB block erase time (ms)
+#define CHIP_BULK_TYP   150000         // Typical bulk erase time (ms)
+#define CHIP_DIRTY_MAX  (CHIP_BULK_TYP / CHIP_BLOCK_TYP)        // 681 block erases take as long as a bulk erase
+
+static uint8_t Dirty[CHIP_BLOCKS / 8];  // Blocks found not blank by EraseChip
+
+/*
+ *  Erase the pending sector range
+ *    The last block erase is left running. An erase error fails the next
+ *    EraseSector, EraseChip, BlankCheck, ProgramPage, Verify or UnInit
+ *    call that accesses the device, and every later one until Init.
+ *    Return Value:   0 - OK,  1 - Failed
+ */
+
+static int EraseFlush (void)
+{
+  uint32_t start = EraseStart;
+  uint32_t end   = EraseEnd;
+
+  if (start == end)
+    return 0;
+
+  EraseStart = EraseEnd = 0;
+  if (SectorErase (start, end) !=0)
+    return 0;
+  else
+    return 1;
+}
+#endif
+
+#if defined FLASH_MEM || defined FLASH_OTP
+/*
+ *  Read back through DCACHE1, drop lines cached before the last erase / program
+ *    Return Value:   previous DCACHE1 enable state
+ */
+
+static uint32_t ReadCacheOn (void)
+{
+  uint32_t dcache = DCACHE1->CR & DCACHE_CR_EN;
+
+  DCACHE1->CR |= DCACHE_CR_EN;
+  DCACHE1->CR |= DCACHE_CR_CACHEINV;
+  while ((DCACHE1->SR & DCACHE_SR_BUSYF) != 0);
+
+  return dcache;
+}
+
+
+/*
+ *  Restore DCACHE1 enable state
+ *    Parameter:      dcache:  State returned by ReadCacheOn
+ */
+
+static void ReadCacheOff (uint32_t dcache)
+{
+  if (dcache == 0)
+    DCACHE1->CR &= ~DCACHE_CR_EN;
+}
+#endif
+
+
 /*
  *  Initialize Flash Programming Functions
  *    Parameter:      adr:  Device Base Address
@@ -22,6 +95,10 @@
 #if defined FLASH_MEM || defined FLASH_OTP
 int Init (unsigned long adr, unsigned long clk, unsigned long fnc)
 {
+#ifdef FLASH_MEM
+  EraseStart = EraseEnd = 0;
+  BaseAdr = adr;
+#endif
   if (Init_OSPI() !=0)
     return 0;
   else 
@@ -39,7 +116,15 @@ int Init (unsigned long adr, unsigned long clk, unsigned long fnc)
 #if defined FLASH_MEM || defined FLASH_OTP
 int UnInit (unsigned long fnc)
 {
-  return (0);
+  int result = 0;
+
+#ifdef FLASH_MEM
+  result = EraseFlush ();
+#endif
+  if (UnInit_OSPI() ==0)
+    result = 1;
+
+  return result;
 }
 #endif
 
@@ -52,10 +137,60 @@ int UnInit (unsigned long fnc)
 #ifdef FLASH_MEM
 int EraseChip (void)
 {
-  if (MassErase() !=0)
-    return 0;
-  else
+  uint32_t block;
+  uint32_t end;
+  uint32_t dirty = 0;
+
+  EraseStart = EraseEnd = 0;
+
+  /* Complete a running erase / program first, the block scan would take its error for a dirty block */
+  if (MemoryMapped_OSPI() ==0)
     return 1;
+
+  /* Probe the start of each 64kB block, a used chip is bulk erased without a full scan */
+  for (block = 0; block < CHIP_BLOCKS; block++)
+  {
+    if (BlankCheck (BaseAdr + block * CHIP_BLOCK, CHIP_PROBE, 0xFF) ==0)
+    {
+      Dirty[block >> 3] &= ~(1U << (block & 7));
+      continue;
+    }
+    Dirty[block >> 3] |= (1U << (block & 7));
+    dirty++;
+  }
+
+  /* Scan the rest of the blocks that probed blank, bulk erase when that is faster */
+  for (block = 0; (block < CHIP_BLOCKS) && (dirty <= CHIP_DIRTY_MAX); block++)
+  {
+    if ((Dirty[block >> 3] & (1U << (block & 7))) != 0)
+      continue;
+    if (BlankCheck (BaseAdr + block * CHIP_BLOCK + CHIP_PROBE, CHIP_BLOCK - CHIP_PROBE, 0xFF) ==0)
+      continue;
+    Dirty[block >> 3] |= (1U << (block & 7));
+    dirty++;
+  }
+  if (dirty > CHIP_DIRTY_MAX)
+  {
+    if (MassErase() !=0)
+      return 0;
+    else
+      return 1;
+  }
+
+  /* Erase runs of dirty blocks, blank blocks are skipped */
+  for (block = 0; block < CHIP_BLOCKS; block = end)
+  {
+    for (end = block; (end < CHIP_BLOCKS) && ((Dirty[end >> 3] & (1U << (end & 7))) != 0); end++);
+    if (end == block)
+    {
+      end++;
+      continue;
+    }
+    if (SectorErase (BaseAdr + block * CHIP_BLOCK, BaseAdr + end * CHIP_BLOCK) ==0)
+      return 1;
+  }
+
+  return 0;
 }
 #endif
 
@@ -69,13 +204,80 @@ int EraseChip (void)
 #ifdef FLASH_MEM
 int EraseSector (unsigned long adr)
 {
-  uint32_t block_start = adr;
-  uint32_t block_size  = 0x10000;
+  /* Collect consecutive 4kB sectors, SectorErase picks 4kB or 64kB erase for the range */
+  if ((uint32_t) adr != EraseEnd)
+  {
+    if (EraseFlush () !=0)
+      return 1;
+    EraseStart = (uint32_t) adr;
+  }
+  EraseEnd = (uint32_t) adr + 0x1000;
 
-  if (SectorErase ((uint32_t) block_start & 0xffffffff ,((uint32_t) block_start & 0xffffffff) + block_size) !=0)
-    return 0;   
-  else 
+  /* Erase the range at each 64kB block boundary */
+  if ((EraseEnd & 0xFFFF) == 0)
+    return EraseFlush ();
+
+  return 0;
+}
+#endif
+
+
+/*
+ *  Blank Check Checks if Memory is Blank
+ *    Parameter:      adr:  Block Start Address
+ *                    sz:   Block Size (in bytes)
+ *                    pat:  Block Pattern
+ *    Return Value:   0 - OK,  1 - Failed
+ */
+
+#ifdef FLASH_MEM
+int BlankCheck (unsigned long adr, unsigned long sz, unsigned char pat)
+{
+  unsigned long end    = adr + sz;
+  uint32_t      pat32  = (uint32_t)pat * 0x01010101U;
+  uint32_t      dcache;
+  int           result = 0;
+
+  /* Range inside the pending erase reads as erased once it is flushed */
+  if ((EraseStart != EraseEnd) && (adr >= EraseStart) && (end <= EraseEnd))
+    return (pat == 0xFF) ? 0 : 1;
+
+  /* Only a range overlapping the pending erase has to wait for it */
+  if ((adr < EraseEnd) && (end > EraseStart))
+  {
+    if (EraseFlush () !=0)
+      return 1;
+  }
+
+  if (adr == end)
+    return 0;
+
+  /* Read in memory-mapped mode, completes a running erase / program */
+  if (MemoryMapped_OSPI() ==0)
     return 1;
+
+  dcache = ReadCacheOn ();
+
+  /* Scan words, stop at the first one that differs from the pattern */
+  while ((end - adr) >= 4)
+  {
+    if (*(const uint32_t *)adr != pat32)
+    {
+      result = 1;
+      break;
+    }
+    adr += 4;
+  }
+  while ((result == 0) && (adr < end))
+  {
+    if (*(const unsigned char *)adr != pat)
+      result = 1;
+    adr++;
+  }
+
+  ReadCacheOff (dcache);
+
+  return result;
 }
 #endif
 
@@ -91,6 +293,10 @@ int EraseSector (unsigned long adr)
 #if defined FLASH_MEM || defined FLASH_OTP
 int ProgramPage (unsigned long block_start, unsigned long size, unsigned char *buffer)
 {
+#ifdef FLASH_MEM
+  if (EraseFlush () !=0)
+    return 1;
+#endif
   if (Write(block_start ,size, buffer) !=0)
     return 0;
   else
@@ -107,12 +313,38 @@ int ProgramPage (unsigned long block_start, unsigned long size, unsigned char *b
  */
 unsigned long Verify (unsigned long adr, unsigned long sz, unsigned char *buf)
 {
-  while (sz-- > 0)
+  unsigned long end = adr + sz;
+  uint32_t      dcache;
+
+  /* Complete pending erase / program, read back in memory-mapped mode */
+#ifdef FLASH_MEM
+  if (EraseFlush () !=0)
+    return adr;
+#endif
+  if (MemoryMapped_OSPI() ==0)
+    return adr;
+
+  /* Read through DCACHE1 */
+  dcache = ReadCacheOn ();
+
+  /* Compare words while flash and buffer are word aligned, bytes otherwise */
+  while (adr < end)
   {
-    if (*(char*)adr++ != *((char*)buf++))
-      return (adr);
+    if ((((adr | (unsigned long)buf) & 3) == 0) && ((end - adr) >= 4) &&
+        (*(uint32_t *)adr == *(uint32_t *)buf))
+    {
+      adr += 4;
+      buf += 4;
+      continue;
+    }
+    if (*(unsigned char *)adr != *buf)
+      break;
+    adr++;
+    buf++;
   }
 
+  ReadCacheOff (dcache);
+
   return adr;
 }
 #endif
@@ -18,8 +18,18 @@
 
 #define TIMEOUT 5000U
 
+/* OSPI memory transfer rate: octal DTR (DOPI) by default,
+   define OSPI_NOR_STR to fall back to octal STR (SOPI) */
+#ifdef OSPI_NOR_STR
+#define OSPI_NOR_TRANSFER_RATE  BSP_OSPI_NOR_STR_TRANSFER
+#else
+#define OSPI_NOR_TRANSFER_RATE  BSP_OSPI_NOR_DTR_TRANSFER
+#endif
+
 /* Private function prototypes -----------------------------------------------*/
 int Init_OSPI(void);
+int UnInit_OSPI(void);
+int MemoryMapped_OSPI(void);
 int Write (uint32_t Address, uint32_t Size, uint8_t* buffer);
 int SectorErase (uint32_t EraseStartAddress ,uint32_t EraseEndAddress);
 int MassErase (void);
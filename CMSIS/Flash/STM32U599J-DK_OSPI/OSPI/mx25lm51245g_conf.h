@@ -34,9 +34,35 @@ extern "C" {
   */
 #define CONF_OSPI_ODS                MX25LM51245G_CR_ODS_24   /* MX25LM51245G Output Driver Strength */
 
-#define DUMMY_CYCLES_READ            8U
+/* OctoSPI bus clock profile (added by ARM), override with -DOSPI_NOR_CLK_PROFILE=<n>
+     0 :  40 MHz, SYSCLK / prescaler (legacy)
+     1 : 100 MHz, PLL2Q kernel clock
+     2 : 133 MHz, PLL2Q kernel clock
+     3 : 200 MHz, PLL2Q kernel clock (MX25LM51245G DTR limit)
+   Octal read dummy cycles follow the selected bus clock. */
+#ifndef OSPI_NOR_CLK_PROFILE
+#define OSPI_NOR_CLK_PROFILE         1U
+#endif
+
+#if   (OSPI_NOR_CLK_PROFILE == 3U)
+#define CONF_OSPI_DC                 MX25LM51245G_CR2_DC_20_CYCLES
+#define DUMMY_CYCLES_READ_OCTAL      20U
+#define DUMMY_CYCLES_READ_OCTAL_DTR  20U
+#elif (OSPI_NOR_CLK_PROFILE == 2U)
+#define CONF_OSPI_DC                 MX25LM51245G_CR2_DC_14_CYCLES
+#define DUMMY_CYCLES_READ_OCTAL      14U
+#define DUMMY_CYCLES_READ_OCTAL_DTR  14U
+#elif (OSPI_NOR_CLK_PROFILE == 1U)
+#define CONF_OSPI_DC                 MX25LM51245G_CR2_DC_10_CYCLES
+#define DUMMY_CYCLES_READ_OCTAL      10U
+#define DUMMY_CYCLES_READ_OCTAL_DTR  10U
+#else
+#define CONF_OSPI_DC                 MX25LM51245G_CR2_DC_6_CYCLES
 #define DUMMY_CYCLES_READ_OCTAL      6U
 #define DUMMY_CYCLES_READ_OCTAL_DTR  6U
+#endif
+
+#define DUMMY_CYCLES_READ            8U
 #define DUMMY_CYCLES_REG_OCTAL       4U
 #define DUMMY_CYCLES_REG_OCTAL_DTR   5U
 
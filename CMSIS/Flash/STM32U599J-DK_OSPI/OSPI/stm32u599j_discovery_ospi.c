@@ -82,6 +82,12 @@
   * @{
   */
 OSPI_HandleTypeDef hospi_nor[OSPI_NOR_INSTANCES_NUMBER] = {0};
+static DMA_HandleTypeDef hdma_ospi_nor = {0};  /* DMA channel for page programming */
+#if (OSPI_NOR_CLK_PROFILE != 0U)
+static LL_DLYB_CfgTypeDef Ospi_Nor_Dlyb[OSPI_NOR_INSTANCES_NUMBER];       /* Delay block calibration */
+static uint32_t           Ospi_Nor_DlybValid[OSPI_NOR_INSTANCES_NUMBER];  /* Calibration done       */
+static uint32_t           Ospi_Nor_KerClkValid;                           /* PLL2Q kernel clock set */
+#endif
 OSPI_NOR_Ctx_t Ospi_Nor_Ctx[OSPI_NOR_INSTANCES_NUMBER] = {{OSPI_ACCESS_NONE,
                                                            MX25LM51245G_SPI_MODE,
                                                            MX25LM51245G_STR_TRANSFER}};
@@ -170,7 +176,11 @@ int32_t BSP_OSPI_NOR_Init(uint32_t Instance, BSP_OSPI_NOR_Init_t *Init)
       (void)MX25LM51245G_GetFlashInfo(&pInfo);
 
       /* Fill config structure */
+#if (OSPI_NOR_CLK_PROFILE == 0U)
       ospi_init.ClockPrescaler = 3; /* 3 ==> 1 KBN */ /* OctoSPI clock = 120MHz / ClockPrescaler = 40MHz */
+#else
+      ospi_init.ClockPrescaler = 1; /* OctoSPI clock = PLL2Q kernel clock */
+#endif
       ospi_init.MemorySize     = (uint32_t)POSITION_VAL((uint32_t)pInfo.FlashSize);
       ospi_init.SampleShifting = HAL_OSPI_SAMPLE_SHIFTING_NONE;
       ospi_init.TransferRate   = (uint32_t) Init->TransferRate;
@@ -180,6 +190,13 @@ int32_t BSP_OSPI_NOR_Init(uint32_t Instance, BSP_OSPI_NOR_Init_t *Init)
       {
         ret = BSP_ERROR_PERIPH_FAILURE;
       }
+#if (OSPI_NOR_CLK_PROFILE != 0U)
+      /* Prescaler 1 is only valid with the PLL2Q kernel clock */
+      else if (Ospi_Nor_KerClkValid == 0UL)
+      {
+        ret = BSP_ERROR_PERIPH_FAILURE;
+      }
+#endif
       /* OSPI Delay Block enable */
       else if (OSPI1_DLYB_Enable(Instance) != BSP_ERROR_NONE)
       {
@@ -429,9 +446,40 @@ int32_t BSP_OSPI_NOR_Read(uint32_t Instance, uint8_t* pData, uint32_t ReadAddr,
   * @retval BSP status
   */
 int32_t BSP_OSPI_NOR_Write(uint32_t Instance, uint8_t* pData, uint32_t WriteAddr, uint32_t Size)
+{
+  int32_t ret;
+
+  /* Program the pages */
+  ret = BSP_OSPI_NOR_Write_Start(Instance, pData, WriteAddr, Size);
+
+  if (ret == BSP_ERROR_NONE)
+  {
+    /* Configure automatic polling mode to wait for end of program */
+    if (MX25LM51245G_AutoPollingMemReady(&hospi_nor[Instance], Ospi_Nor_Ctx[Instance].InterfaceMode, Ospi_Nor_Ctx[Instance].TransferRate) != MX25LM51245G_OK)
+    {
+      ret = BSP_ERROR_COMPONENT_FAILURE;
+    }
+  }
+
+  /* Return BSP status */
+  return ret;
+}
+
+/**
+  * @brief  Writes an amount of data to the OSPI memory without waiting for
+  *         the end of the last page program (added by ARM).
+  *         Completion is checked with BSP_OSPI_NOR_GetStatus().
+  * @param  Instance  OSPI instance
+  * @param  pData     Pointer to data to be written
+  * @param  WriteAddr Write start address
+  * @param  Size      Size of data to write
+  * @retval BSP status
+  */
+int32_t BSP_OSPI_NOR_Write_Start(uint32_t Instance, uint8_t* pData, uint32_t WriteAddr, uint32_t Size)
 {
   int32_t ret = BSP_ERROR_NONE;
   uint32_t end_addr, current_size, current_addr;
+  uint32_t prog_start, prog_end;
   uint32_t data_addr;
 
   /* Check if the instance is supported */
@@ -458,8 +506,30 @@ int32_t BSP_OSPI_NOR_Write(uint32_t Instance, uint8_t* pData, uint32_t WriteAddr
     /* Perform the write page by page */
     do
     {
+      /* Skip the erased (0xFF) head and tail of the page, programming 0xFF leaves
+         NOR content unchanged. DTR keeps the program on even addresses (added by ARM) */
+      prog_start = 0U;
+      prog_end = current_size;
+      while ((prog_start < prog_end) && (((uint8_t *)data_addr)[prog_start] == 0xFFU))
+      {
+        prog_start++;
+      }
+      while ((prog_end > prog_start) && (((uint8_t *)data_addr)[prog_end - 1U] == 0xFFU))
+      {
+        prog_end--;
+      }
+      if ((Ospi_Nor_Ctx[Instance].TransferRate != BSP_OSPI_NOR_STR_TRANSFER) && (prog_end > prog_start))
+      {
+        prog_start &= ~1U;
+        prog_end = (prog_end + 1U) & ~1U;
+      }
+
+      if(prog_start == prog_end)
+      {
+        /* Nothing to program in this page */
+      }
       /* Check if Flash busy ? */
-      if(MX25LM51245G_AutoPollingMemReady(&hospi_nor[Instance], Ospi_Nor_Ctx[Instance].InterfaceMode, Ospi_Nor_Ctx[Instance].TransferRate) != MX25LM51245G_OK)
+      else if(MX25LM51245G_AutoPollingMemReady(&hospi_nor[Instance], Ospi_Nor_Ctx[Instance].InterfaceMode, Ospi_Nor_Ctx[Instance].TransferRate) != MX25LM51245G_OK)
       {
         ret = BSP_ERROR_COMPONENT_FAILURE;
       }/* Enable write operations */
@@ -472,7 +542,7 @@ int32_t BSP_OSPI_NOR_Write(uint32_t Instance, uint8_t* pData, uint32_t WriteAddr
         if(Ospi_Nor_Ctx[Instance].TransferRate == BSP_OSPI_NOR_STR_TRANSFER)
         {
           /* Issue page program command */
-          if(MX25LM51245G_PageProgram(&hospi_nor[Instance], Ospi_Nor_Ctx[Instance].InterfaceMode, MX25LM51245G_4BYTES_SIZE, (uint8_t*)data_addr, current_addr, current_size) != MX25LM51245G_OK)
+          if(MX25LM51245G_PageProgram(&hospi_nor[Instance], Ospi_Nor_Ctx[Instance].InterfaceMode, MX25LM51245G_4BYTES_SIZE, (uint8_t*)(data_addr + prog_start), current_addr + prog_start, prog_end - prog_start) != MX25LM51245G_OK)
           {
             ret = BSP_ERROR_COMPONENT_FAILURE;
           }
@@ -480,27 +550,19 @@ int32_t BSP_OSPI_NOR_Write(uint32_t Instance, uint8_t* pData, uint32_t WriteAddr
         else
         {
           /* Issue page program command */
-          if(MX25LM51245G_PageProgramDTR(&hospi_nor[Instance], (uint8_t*)data_addr, current_addr, current_size) != MX25LM51245G_OK)
+          if(MX25LM51245G_PageProgramDTR(&hospi_nor[Instance], (uint8_t*)(data_addr + prog_start), current_addr + prog_start, prog_end - prog_start) != MX25LM51245G_OK)
           {
             ret = BSP_ERROR_COMPONENT_FAILURE;
           }
         }
+      }
 
-        if (ret == BSP_ERROR_NONE)
-        {
-          /* Configure automatic polling mode to wait for end of program */
-          if (MX25LM51245G_AutoPollingMemReady(&hospi_nor[Instance], Ospi_Nor_Ctx[Instance].InterfaceMode, Ospi_Nor_Ctx[Instance].TransferRate) != MX25LM51245G_OK)
-          {
-            ret = BSP_ERROR_COMPONENT_FAILURE;
-          }
-          else
-          {
-            /* Update the address and size variables for next page programming */
-            current_addr += current_size;
-            data_addr += current_size;
-            current_size = ((current_addr + MX25LM51245G_PAGE_SIZE) > end_addr) ? (end_addr - current_addr) : MX25LM51245G_PAGE_SIZE;
-          }
-        }
+      if (ret == BSP_ERROR_NONE)
+      {
+        /* Update the address and size variables for next page programming */
+        current_addr += current_size;
+        data_addr += current_size;
+        current_size = ((current_addr + MX25LM51245G_PAGE_SIZE) > end_addr) ? (end_addr - current_addr) : MX25LM51245G_PAGE_SIZE;
       }
     } while ((current_addr < end_addr) && (ret == BSP_ERROR_NONE));
   }
@@ -999,6 +1061,7 @@ int32_t BSP_OSPI_NOR_LeaveDeepPowerDown(uint32_t Instance)
   * @{
   */
  
+#if (OSPI_NOR_CLK_PROFILE == 0U)
 /**
   * @brief  This function enables delay block.
   * @param  Instance  OSPI instance
@@ -1019,6 +1082,59 @@ static int32_t OSPI1_DLYB_Enable(uint32_t Instance)
 	
   return BSP_ERROR_NONE;
 }
+#else
+/**
+  * @brief  This function enables delay block.
+  *         The delay is calibrated on the OctoSPI clock once and the result
+  *         is reused for the rest of the session.
+  * @param  Instance  OSPI instance
+  * @retval BSP status
+  */
+static int32_t OSPI1_DLYB_Enable(uint32_t Instance)
+{
+  LL_DLYB_CfgTypeDef dlyb_cfg, dlyb_cfg_test;
+  int32_t ret = BSP_ERROR_NONE;
+
+  if (Ospi_Nor_DlybValid[Instance] == 0U)
+  {
+    /* Measure the OctoSPI clock period */
+    if (HAL_OSPI_DLYB_GetClockPeriod(&hospi_nor[Instance], &dlyb_cfg) != HAL_OK)
+    {
+      return BSP_ERROR_PERIPH_FAILURE;
+    }
+
+    /* when DTR, PhaseSel is divided by 4 (emperic value) */
+    if (hospi_nor[Instance].Init.DelayHoldQuarterCycle == HAL_OSPI_DHQC_ENABLE)
+    {
+      dlyb_cfg.PhaseSel /= 4UL;
+    }
+
+    Ospi_Nor_Dlyb[Instance]      = dlyb_cfg;
+    Ospi_Nor_DlybValid[Instance] = 1U;
+  }
+
+  /* save the present configuration for check */
+  dlyb_cfg      = Ospi_Nor_Dlyb[Instance];
+  dlyb_cfg_test = dlyb_cfg;
+
+  /* set delay block configuration */
+  if (HAL_OSPI_DLYB_SetConfig(&hospi_nor[Instance], &dlyb_cfg) != HAL_OK)
+  {
+    ret = BSP_ERROR_PERIPH_FAILURE;
+  }
+  /* check the set value */
+  if (HAL_OSPI_DLYB_GetConfig(&hospi_nor[Instance], &dlyb_cfg) != HAL_OK)
+  {
+    ret = BSP_ERROR_PERIPH_FAILURE;
+  }
+  if ((dlyb_cfg.PhaseSel != dlyb_cfg_test.PhaseSel) || (dlyb_cfg.Units != dlyb_cfg_test.Units))
+  {
+    ret = BSP_ERROR_PERIPH_FAILURE;
+  }
+
+  return ret;
+}
+#endif
     
 /**
   * @brief  Initializes the OSPI MSP.
@@ -1028,10 +1144,36 @@ static int32_t OSPI1_DLYB_Enable(uint32_t Instance)
 static void OSPI_NOR_MspInit(OSPI_HandleTypeDef *hospi)
 {
   GPIO_InitTypeDef GPIO_InitStruct;
+#if (OSPI_NOR_CLK_PROFILE != 0U)
+  RCC_PeriphCLKInitTypeDef PeriphClkInit = {0};
+#endif
       
   /* hospi unused argument(s) compilation warning */
   UNUSED(hospi);
 
+#if (OSPI_NOR_CLK_PROFILE != 0U)
+  /* Select PLL2Q as OctoSPI kernel clock */
+  PeriphClkInit.PeriphClockSelection = RCC_PERIPHCLK_OSPI;
+  PeriphClkInit.OspiClockSelection   = RCC_OSPICLKSOURCE_PLL2;
+  PeriphClkInit.PLL2.PLL2Source      = RCC_PLLSOURCE_MSI;
+  PeriphClkInit.PLL2.PLL2M           = 1;
+  PeriphClkInit.PLL2.PLL2N           = OSPI_KERCLK_PLL2N;
+  PeriphClkInit.PLL2.PLL2P           = 2;
+  PeriphClkInit.PLL2.PLL2Q           = OSPI_KERCLK_PLL2Q;
+  PeriphClkInit.PLL2.PLL2R           = 2;
+  PeriphClkInit.PLL2.PLL2RGE         = RCC_PLLVCIRANGE_0;
+  PeriphClkInit.PLL2.PLL2FRACN       = 0;
+  PeriphClkInit.PLL2.PLL2ClockOut    = RCC_PLL2_DIVQ;
+  if (HAL_RCCEx_PeriphCLKConfig(&PeriphClkInit) == HAL_OK)
+  {
+    Ospi_Nor_KerClkValid = 1UL;
+  }
+  else
+  {
+    Ospi_Nor_KerClkValid = 0UL;
+  }
+#endif
+
   /* Enable the OctoSPI memory interface clock */
   OSPI_CLK_ENABLE();
 
@@ -1115,6 +1257,28 @@ static void OSPI_NOR_MspInit(OSPI_HandleTypeDef *hospi)
   /* NVIC configuration for OSPI interrupt */
   HAL_NVIC_SetPriority(OCTOSPI1_IRQn, 0x0F, 0);
   HAL_NVIC_EnableIRQ(OCTOSPI1_IRQn);
+
+  /* Configure the DMA channel used for page programming, the polled
+     FIFO transfer is used if it cannot be initialized */
+  OSPI_DMA_CLK_ENABLE();
+  hdma_ospi_nor.Instance                   = OSPI_DMA_INSTANCE;
+  hdma_ospi_nor.Init.Request               = OSPI_DMA_REQUEST;
+  hdma_ospi_nor.Init.BlkHWRequest          = DMA_BREQ_SINGLE_BURST;
+  hdma_ospi_nor.Init.Direction             = DMA_MEMORY_TO_PERIPH;
+  hdma_ospi_nor.Init.SrcInc                = DMA_SINC_INCREMENTED;
+  hdma_ospi_nor.Init.DestInc               = DMA_DINC_FIXED;
+  hdma_ospi_nor.Init.SrcDataWidth          = DMA_SRC_DATAWIDTH_WORD;
+  hdma_ospi_nor.Init.DestDataWidth         = DMA_DEST_DATAWIDTH_WORD;
+  hdma_ospi_nor.Init.Priority              = DMA_HIGH_PRIORITY;
+  hdma_ospi_nor.Init.SrcBurstLength        = 1;
+  hdma_ospi_nor.Init.DestBurstLength       = 1;
+  hdma_ospi_nor.Init.TransferAllocatedPort = (DMA_SRC_ALLOCATED_PORT0 | DMA_DEST_ALLOCATED_PORT0);
+  hdma_ospi_nor.Init.TransferEventMode     = DMA_TCEM_BLOCK_TRANSFER;
+  hdma_ospi_nor.Init.Mode                  = DMA_NORMAL;
+  if (HAL_DMA_Init(&hdma_ospi_nor) == HAL_OK)
+  {
+    __HAL_LINKDMA(hospi, hdma, hdma_ospi_nor);
+  }
 }
 
 /**
@@ -1126,6 +1290,13 @@ static void OSPI_NOR_MspDeInit(OSPI_HandleTypeDef *hospi)
 {
   /* hospi unused argument(s) compilation warning */
   UNUSED(hospi);
+
+  /* DMA channel de-configuration */
+  if (hospi->hdma != NULL)
+  {
+    (void)HAL_DMA_DeInit(hospi->hdma);
+    hospi->hdma = NULL;
+  }
   /* OctoSPI GPIO pins de-configuration  */
   HAL_GPIO_DeInit(OSPI_CLK_GPIO_PORT, OSPI_CLK_PIN);
   HAL_GPIO_DeInit(OSPI_DQS_GPIO_PORT, OSPI_DQS_PIN);
@@ -1222,7 +1393,7 @@ static int32_t OSPI_NOR_EnterDOPIMode(uint32_t Instance)
     ret = BSP_ERROR_COMPONENT_FAILURE;
   }
   /* Write Configuration register 2 (with new dummy cycles) */
-  else if (MX25LM51245G_WriteCfg2Register(&hospi_nor[Instance], Ospi_Nor_Ctx[Instance].InterfaceMode, Ospi_Nor_Ctx[Instance].TransferRate, MX25LM51245G_CR2_REG3_ADDR, MX25LM51245G_CR2_DC_6_CYCLES) != MX25LM51245G_OK)
+  else if (MX25LM51245G_WriteCfg2Register(&hospi_nor[Instance], Ospi_Nor_Ctx[Instance].InterfaceMode, Ospi_Nor_Ctx[Instance].TransferRate, MX25LM51245G_CR2_REG3_ADDR, CONF_OSPI_DC) != MX25LM51245G_OK)
   {
     ret = BSP_ERROR_COMPONENT_FAILURE;
   }
@@ -1293,7 +1464,7 @@ static int32_t OSPI_NOR_EnterSOPIMode(uint32_t Instance)
     ret = BSP_ERROR_COMPONENT_FAILURE;
   }
   /* Write Configuration register 2 (with new dummy cycles) */
-  else if (MX25LM51245G_WriteCfg2Register(&hospi_nor[Instance], Ospi_Nor_Ctx[Instance].InterfaceMode, Ospi_Nor_Ctx[Instance].TransferRate, MX25LM51245G_CR2_REG3_ADDR, MX25LM51245G_CR2_DC_6_CYCLES) != MX25LM51245G_OK)
+  else if (MX25LM51245G_WriteCfg2Register(&hospi_nor[Instance], Ospi_Nor_Ctx[Instance].InterfaceMode, Ospi_Nor_Ctx[Instance].TransferRate, MX25LM51245G_CR2_REG3_ADDR, CONF_OSPI_DC) != MX25LM51245G_OK)
   {
     ret = BSP_ERROR_COMPONENT_FAILURE;
   }
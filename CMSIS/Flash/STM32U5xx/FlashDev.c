@@ -18,13 +18,16 @@
  * 3. This notice may not be removed or altered from any source distribution.
  *
  *
- * $Date:        31. October 2023
- * $Revision:    V1.3.0
+ * $Date:        17. October 2026
+ * $Revision:    V1.4.0
  *
  * Project:      Flash Device Description for ST STM32U5xx Flash
  * --------------------------------------------------------------------------- */
 
 /* History:
+ *  Version 1.4.0
+ *    Programming page size set to sector size (8kB)
+ *    Added option bytes algorithm
  *  Version 1.3.0
  *    Added more algorithms
  *  Version 1.2.0
@@ -46,11 +49,11 @@
     ONCHIP,                            /* Device Type */
     0x0C000000,                        /* Device Start Address */
     0x00400000,                        /* Device Size in Bytes (4MB) */
-    1024,                              /* Programming Page Size */
+    0x2000,                            /* Programming Page Size 8kB (= Sector Size) */
     0,                                 /* Reserved, must be 0 */
     0xFF,                              /* Initial Content of Erased Memory */
-    400,                               /* Program Page Timeout 400 mSec */
-    400,                               /* Erase Sector Timeout 400 mSec */
+    3000,                              /* Program Page Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
+    3000,                              /* Erase Sector Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
     /* Specify Size and Address of Sectors */
     0x2000, 0x000000,                  /* Sector Size 8kB */
     SECTOR_END
@@ -64,11 +67,11 @@
     ONCHIP,                            /* Device Typev */
     0x08000000,                        /* Device Start Address */
     0x00400000,                        /* Device Size in Bytes (4MB) */
-    1024,                              /* Programming Page Size */
+    0x2000,                            /* Programming Page Size 8kB (= Sector Size) */
     0,                                 /* Reserved, must be 0 */
     0xFF,                              /* Initial Content of Erased Memory */
-    400,                               /* Program Page Timeout 400 mSec */
-    400,                               /* Erase Sector Timeout 400 mSec */
+    3000,                              /* Program Page Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
+    3000,                              /* Erase Sector Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
     /* Specify Size and Address of Sectors */
     0x2000, 0x000000,                  /* Sector Size 8kB */
     SECTOR_END
@@ -82,11 +85,11 @@
     ONCHIP,                            /* Device Type */
     0x08000000,                        /* Device Start Address */
     0x00200000,                        // Device Size in Bytes (2MB) */
-    1024,                              /* Programming Page Size */
+    0x2000,                            /* Programming Page Size 8kB (= Sector Size) */
     0,                                 /* Reserved, must be 0 */
     0xFF,                              /* Initial Content of Erased Memory */
-    400,                               /* Program Page Timeout 400 mSec */
-    400,                               /* Erase Sector Timeout 400 mSec */
+    3000,                              /* Program Page Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
+    3000,                              /* Erase Sector Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
     /* Specify Size and Address of Sectors */
     0x2000, 0x000000,                  /* Sector Size 8kB */
     SECTOR_END
@@ -100,11 +103,11 @@
     ONCHIP,                            /* Device Type */
     0x0C000000,                        /* Device Start Address */
     0x00200000,                        /* Device Size in Bytes (2MB) */
-    1024,                              /* Programming Page Size */
+    0x2000,                            /* Programming Page Size 8kB (= Sector Size) */
     0,                                 /* Reserved, must be 0 */
     0xFF,                              /* Initial Content of Erased Memory */
-    400,                               /* Program Page Timeout 400 mSec */
-    400,                               /* Erase Sector Timeout 400 mSec */
+    3000,                              /* Program Page Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
+    3000,                              /* Erase Sector Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
     /* Specify Size and Address of Sectors */
     0x2000, 0x000000,                  /* Sector Size 8kB */
     SECTOR_END
@@ -118,11 +121,11 @@
     ONCHIP,                            /* Device Type */
     0x08000000,                        /* Device Start Address */
     0x00400000,                        /* Device Size in Bytes (4MB) */
-    1024,                              /* Programming Page Size */
+    0x2000,                            /* Programming Page Size 8kB (= Sector Size) */
     0,                                 /* Reserved, must be 0 */
     0xFF,                              /* Initial Content of Erased Memory */
-    400,                               /* Program Page Timeout 400 mSec */
-    400,                               /* Erase Sector Timeout 400 mSec */
+    3000,                              /* Program Page Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
+    3000,                              /* Erase Sector Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
     /* Specify Size and Address of Sectors */
     0x2000, 0x000000,                  /* Sector Size  8kB (512 Sectore) */
     SECTOR_END
@@ -136,11 +139,11 @@
     ONCHIP,                            /* Device Type */
     0x0C000000,                        /* Device Start Address */
     0x00400000,                        /* Device Size in Bytes (4MB) */
-    1024,                              /* Programming Page Size */
+    0x2000,                            /* Programming Page Size 8kB (= Sector Size) */
     0,                                 /* Reserved, must be 0 */
     0xFF,                              /* Initial Content of Erased Memory */
-    400,                               /* Program Page Timeout 400 mSec */
-    400,                               /* Erase Sector Timeout 400 mSec */
+    3000,                              /* Program Page Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
+    3000,                              /* Erase Sector Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
     /* Specify Size and Address of Sectors */
     0x2000, 0x000000,                  /* Sector Size  8kB (512 Sectore) */
     SECTOR_END
@@ -154,11 +157,11 @@
     ONCHIP,                            /* Device Type */
     0x08000000,                        /* Device Start Address */
     0x00200000,                        // Device Size in Bytes (2MB) */
-    1024,                              /* Programming Page Size */
+    0x2000,                            /* Programming Page Size 8kB (= Sector Size) */
     0,                                 /* Reserved, must be 0 */
     0xFF,                              /* Initial Content of Erased Memory */
-    400,                               /* Program Page Timeout 400 mSec */
-    400,                               /* Erase Sector Timeout 400 mSec */
+    3000,                              /* Program Page Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
+    3000,                              /* Erase Sector Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
     /* Specify Size and Address of Sectors */
     0x2000, 0x000000,                  /* Sector Size  8kB (256 Sectore) */
     SECTOR_END
@@ -172,11 +175,11 @@
     ONCHIP,                            /* Device Type */
     0x0C000000,                        /* Device Start Address */
     0x00200000,                        /* Device Size in Bytes (2MB) */
-    1024,                              /* Programming Page Size */
+    0x2000,                            /* Programming Page Size 8kB (= Sector Size) */
     0,                                 /* Reserved, must be 0 */
     0xFF,                              /* Initial Content of Erased Memory */
-    400,                               /* Program Page Timeout 400 mSec */
-    400,                               /* Erase Sector Timeout 400 mSec */
+    3000,                              /* Program Page Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
+    3000,                              /* Erase Sector Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
     /* Specify Size and Address of Sectors */
     0x2000, 0x000000,                  /* Sector Size  8kB (256 Sectore) */
     SECTOR_END
@@ -190,11 +193,11 @@
     ONCHIP,                            /* Device Type */
     0x08000000,                        /* Device Start Address */
     0x00200000,                        /* Device Size in Bytes (2048 kB) */
-    1024,                              /* Programming Page Size */
+    0x2000,                            /* Programming Page Size 8kB (= Sector Size) */
     0,                                 /* Reserved, must be 0 */
     0xFF,                              /* Initial Content of Erased Memory */
-    400,                               /* Program Page Timeout 400 mSec */
-    400,                               /* Erase Sector Timeout 400 mSec */
+    3000,                              /* Program Page Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
+    3000,                              /* Erase Sector Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
     /* Specify Size and Address of Sectors */
     0x2000, 0x000000,                  /* Sector Size  8kB (256 Sectore) */
     SECTOR_END
@@ -208,11 +211,11 @@
     ONCHIP,                            /* Device Type */
     0x0C000000,                        /* Device Start Address */
     0x00200000,                        /* Device Size in Bytes (2048 kB) */
-    1024,                              /* Programming Page Size */
+    0x2000,                            /* Programming Page Size 8kB (= Sector Size) */
     0,                                 /* Reserved, must be 0 */
     0xFF,                              /* Initial Content of Erased Memory */
-    400,                               /* Program Page Timeout 400 mSec */
-    400,                               /* Erase Sector Timeout 400 mSec */
+    3000,                              /* Program Page Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
+    3000,                              /* Erase Sector Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
     /* Specify Size and Address of Sectors */
     0x2000, 0x000000,                  /* Sector Size  8kB (256 Sectore) */
     SECTOR_END
@@ -226,11 +229,11 @@
     ONCHIP,                            /* Device Type */
     0x08000000,                        /* Device Start Address */
     0x00100000,                        /* Device Size in Bytes (1024 kB) */
-    1024,                              /* Programming Page Size */
+    0x2000,                            /* Programming Page Size 8kB (= Sector Size) */
     0,                                 /* Reserved, must be 0 */
     0xFF,                              /* Initial Content of Erased Memory */
-    400,                               /* Program Page Timeout 400 mSec */
-    400,                               /* Erase Sector Timeout 400 mSec */
+    3000,                              /* Program Page Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
+    3000,                              /* Erase Sector Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
     /* Specify Size and Address of Sectors */
     0x2000, 0x000000,                  /* Sector Size  8kB (128 Sectore) */
     SECTOR_END
@@ -244,11 +247,11 @@
     ONCHIP,                            /* Device Type */
     0x0C000000,                        /* Device Start Address */
     0x00100000,                        /* Device Size in Bytes (1024 kB) */
-    1024,                              /* Programming Page Size */
+    0x2000,                            /* Programming Page Size 8kB (= Sector Size) */
     0,                                 /* Reserved, must be 0 */
     0xFF,                              /* Initial Content of Erased Memory */
-    400,                               /* Program Page Timeout 400 mSec */
-    400,                               /* Erase Sector Timeout 400 mSec */
+    3000,                              /* Program Page Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
+    3000,                              /* Erase Sector Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
     /* Specify Size and Address of Sectors */
     0x2000, 0x000000,                  /* Sector Size  8kB (128 Sectore) */
     SECTOR_END
@@ -262,11 +265,11 @@
     ONCHIP,                            /* Device Type */
     0x08000000,                        /* Device Start Address */
     0x00080000,                        /* Device Size in Bytes (512KB) */
-    1024,                              /* Programming Page Size */
+    0x2000,                            /* Programming Page Size 8kB (= Sector Size) */
     0,                                 /* Reserved, must be 0 */
     0xFF,                              /* Initial Content of Erased Memory */
-    400,                               /* Program Page Timeout 400 mSec */
-    400,                               /* Erase Sector Timeout 400 mSec */
+    3000,                              /* Program Page Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
+    3000,                              /* Erase Sector Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
     /* Specify Size and Address of Sectors */
     0x2000, 0x000000,                  /* Sector Size  8kB (64 Sectore) */
     SECTOR_END
@@ -279,11 +282,11 @@
     ONCHIP,                            /* Device Type */
     0x0C000000,                        /* Device Start Address */
     0x00080000,                        /* Device Size in Bytes (512KB) */
-    1024,                              /* Programming Page Size */
+    0x2000,                            /* Programming Page Size 8kB (= Sector Size) */
     0,                                 /* Reserved, must be 0 */
     0xFF,                              /* Initial Content of Erased Memory */
-    400,                               /* Program Page Timeout 400 mSec */
-    400,                               /* Erase Sector Timeout 400 mSec */
+    3000,                              /* Program Page Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
+    3000,                              /* Erase Sector Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
     /* Specify Size and Address of Sectors */
     0x2000, 0x000000,                  /* Sector Size  8kB (64 Sectore) */
     SECTOR_END
@@ -296,11 +299,11 @@
     ONCHIP,                            /* Device Type */
     0x08000000,                        /* Device Start Address */
     0x00040000,                        /* Device Size in Bytes (256KB) */
-    1024,                              /* Programming Page Size */
+    0x2000,                            /* Programming Page Size 8kB (= Sector Size) */
     0,                                 /* Reserved, must be 0 */
     0xFF,                              /* Initial Content of Erased Memory */
-    400,                               /* Program Page Timeout 400 mSec */
-    400,                               /* Erase Sector Timeout 400 mSec */
+    3000,                              /* Program Page Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
+    3000,                              /* Erase Sector Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
     /* Specify Size and Address of Sectors */
     0x2000, 0x000000,                  /* Sector Size  8kB (32 Sectore) */
     SECTOR_END
@@ -314,11 +317,11 @@
     ONCHIP,                            /* Device Type */
     0x0C000000,                        /* Device Start Address */
     0x00040000,                        /* Device Size in Bytes (256KB) */
-    1024,                              /* Programming Page Size */
+    0x2000,                            /* Programming Page Size 8kB (= Sector Size) */
     0,                                 /* Reserved, must be 0 */
     0xFF,                              /* Initial Content of Erased Memory */
-    400,                               /* Program Page Timeout 400 mSec */
-    400,                               /* Erase Sector Timeout 400 mSec */
+    3000,                              /* Program Page Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
+    3000,                              /* Erase Sector Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
     /* Specify Size and Address of Sectors */
     0x2000, 0x000000,                  /* Sector Size  8kB (32 Sectore) */
     SECTOR_END
@@ -332,11 +335,11 @@
     ONCHIP,                            /* Device Type */
     0x08000000,                        /* Device Start Address */
     0x00020000,                        /* Device Size in Bytes (128KB) */
-    1024,                              /* Programming Page Size */
+    0x2000,                            /* Programming Page Size 8kB (= Sector Size) */
     0,                                 /* Reserved, must be 0 */
     0xFF,                              /* Initial Content of Erased Memory */
-    400,                               /* Program Page Timeout 400 mSec */
-    400,                               /* Erase Sector Timeout 400 mSec */
+    3000,                              /* Program Page Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
+    3000,                              /* Erase Sector Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
     /* Specify Size and Address of Sectors */
     0x2000, 0x000000,                  /* Sector Size  8kB (16 Sectore) */
     SECTOR_END
@@ -350,11 +353,11 @@
     ONCHIP,                            /* Device Type */
     0x0C000000,                        /* Device Start Address */
     0x00020000,                        /* Device Size in Bytes (128KB) */
-    1024,                              /* Programming Page Size */
+    0x2000,                            /* Programming Page Size 8kB (= Sector Size) */
     0,                                 /* Reserved, must be 0 */
     0xFF,                              /* Initial Content of Erased Memory */
-    400,                               /* Program Page Timeout 400 mSec */
-    400,                               /* Erase Sector Timeout 400 mSec */
+    3000,                              /* Program Page Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
+    3000,                              /* Erase Sector Timeout 3 Sec (incl. pending page erases, max. 2.5 Sec) */
     /* Specify Size and Address of Sectors */
     0x2000, 0x000000,                  /* Sector Size  8kB (16 Sectore) */
     SECTOR_END
@@ -362,3 +365,22 @@
 #endif
 
 #endif /* FLASH_MEM */
+
+
+#ifdef FLASH_OPT
+  struct FlashDevice const FlashDevice  =  {
+    FLASH_DRV_VERS,                    /* Driver Version, do not modify! */
+    "STM32U5xx Flash Options",         /* Device Name */
+    ONCHIP,                            /* Device Type */
+    0x40022040,                        /* Device Start Address (FLASH_OPTR) */
+    0x00000030,                        /* Device Size in Bytes (48) */
+    0x0030,                            /* Programming Page Size */
+    0,                                 /* Reserved, must be 0 */
+    0xFF,                              /* Initial Content of Erased Memory */
+    3000,                              /* Program Page Timeout 3 Sec */
+    3000,                              /* Erase Sector Timeout 3 Sec */
+    /* Specify Size and Address of Sectors */
+    0x0030, 0x000000,                  /* Sector Size 48B */
+    SECTOR_END
+  };
+#endif /* FLASH_OPT */
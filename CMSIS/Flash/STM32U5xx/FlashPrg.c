@@ -18,13 +18,24 @@
  * 3. This notice may not be removed or altered from any source distribution.
  *
  *
- * $Date:        31. October 2023
- * $Revision:    V1.3.0
+ * $Date:        17. October 2026
+ * $Revision:    V1.4.0
  *
  * Project:      Flash Device Description for ST STM32U5xx Flash
  * --------------------------------------------------------------------------- */
 
 /* History:
+ *  Version 1.4.0
+ *    Added burst programming (8 quad-words) to ProgramPage
+ *    Added ECC aware BlankCheck for Flash memory (ECCD NMI caught during reads)
+ *    Added Verify for Flash memory
+ *    EraseSector merges consecutive sectors, complete banks are mass erased
+ *    Flash geometry is decoded once in Init
+ *    Added optional SYSCLK boost to 160 MHz (FLASH_CLK_BOOST, *_Boost targets)
+ *    ProgramPage skips quad-words and bursts containing only 0xFF
+ *    Added DWT cycle counter based timeouts and timing record (gFlashTiming),
+ *      timeouts follow the core clock configured in RCC
+ *    Implemented Option Bytes algorithm (single OPTSTRT in UnInit)
  *  Version 1.3.0
  *    Added more algorithms
  *  Version 1.2.0
@@ -41,24 +52,96 @@
 
 #include "..\FlashOS.h"        /* FlashOS Structures */
 
+typedef volatile unsigned char    vu8;
 typedef volatile unsigned long    vu32;
 typedef          unsigned long     u32;
 
+#define M8(adr)  (*((vu8  *) (adr)))
 #define M32(adr) (*((vu32 *) (adr)))
 
 // Peripheral Memory Map
 #define FLASH_BASE       (0x40022000)
 #define DBGMCU_BASE      (0xE0044000)
+#define DWT_BASE         (0xE0001000)
+#define DEMCR_BASE       (0xE000EDFC)
+#define SCB_VTOR_BASE    (0xE000ED08)
 #define FLASHSIZE_BASE   (0x0BFA07A0)
+#define RCC_BASE         (0x46020C00)
+#define PWR_BASE         (0x46020800)
 
 #define FLASH           ((FLASH_TypeDef  *) FLASH_BASE)
 #define DBGMCU          ((DBGMCU_TypeDef *) DBGMCU_BASE)
+#define RCC             ((RCC_TypeDef    *) RCC_BASE)
+#define PWR             ((PWR_TypeDef    *) PWR_BASE)
+#define DWT             ((DWT_TypeDef    *) DWT_BASE)
+#define DEMCR           (*((vu32 *) DEMCR_BASE))
+#define SCB_VTOR        (*((vu32 *) SCB_VTOR_BASE))
 
 // Debug MCU
 typedef struct {
   vu32 IDCODE;
 } DBGMCU_TypeDef;
 
+// Data Watchpoint and Trace
+typedef struct {
+  vu32 CTRL;             /* Offset: 0x00  DWT control register */
+  vu32 CYCCNT;           /* Offset: 0x04  DWT cycle count register */
+} DWT_TypeDef;
+
+// Reset and Clock Control Registers
+typedef struct
+{
+  vu32 CR;               /* Offset: 0x00  RCC clock control register */
+  vu32 RESERVED1;
+  vu32 ICSCR1;           /* Offset: 0x08  RCC internal clock sources calibration register 1 */
+  vu32 ICSCR2;           /* Offset: 0x0C  RCC internal clock sources calibration register 2 */
+  vu32 ICSCR3;           /* Offset: 0x10  RCC internal clock sources calibration register 3 */
+  vu32 CRRCR;            /* Offset: 0x14  RCC clock recovery RC register */
+  vu32 RESERVED2;
+  vu32 CFGR1;            /* Offset: 0x1C  RCC clock configuration register 1 */
+  vu32 CFGR2;            /* Offset: 0x20  RCC clock configuration register 2 */
+  vu32 CFGR3;            /* Offset: 0x24  RCC clock configuration register 3 */
+  vu32 PLL1CFGR;         /* Offset: 0x28  RCC PLL1 configuration register */
+  vu32 PLL2CFGR;         /* Offset: 0x2C  RCC PLL2 configuration register */
+  vu32 PLL3CFGR;         /* Offset: 0x30  RCC PLL3 configuration register */
+  vu32 PLL1DIVR;         /* Offset: 0x34  RCC PLL1 dividers register */
+  vu32 PLL1FRACR;        /* Offset: 0x38  RCC PLL1 fractional divider register */
+  vu32 PLL2DIVR;         /* Offset: 0x3C  RCC PLL2 dividers register */
+  vu32 PLL2FRACR;        /* Offset: 0x40  RCC PLL2 fractional divider register */
+  vu32 PLL3DIVR;         /* Offset: 0x44  RCC PLL3 dividers register */
+  vu32 PLL3FRACR;        /* Offset: 0x48  RCC PLL3 fractional divider register */
+  vu32 RESERVED3;
+  vu32 CIER;             /* Offset: 0x50  RCC clock interrupt enable register */
+  vu32 CIFR;             /* Offset: 0x54  RCC clock interrupt flag register */
+  vu32 CICR;             /* Offset: 0x58  RCC clock interrupt clear register */
+  vu32 RESERVED4;
+  vu32 AHB1RSTR;         /* Offset: 0x60  RCC AHB1 peripheral reset register */
+  vu32 AHB2RSTR1;        /* Offset: 0x64  RCC AHB2 peripheral reset register 1 */
+  vu32 AHB2RSTR2;        /* Offset: 0x68  RCC AHB2 peripheral reset register 2 */
+  vu32 AHB3RSTR;         /* Offset: 0x6C  RCC AHB3 peripheral reset register */
+  vu32 RESERVED5;
+  vu32 APB1RSTR1;        /* Offset: 0x74  RCC APB1 peripheral reset register 1 */
+  vu32 APB1RSTR2;        /* Offset: 0x78  RCC APB1 peripheral reset register 2 */
+  vu32 APB2RSTR;         /* Offset: 0x7C  RCC APB2 peripheral reset register */
+  vu32 APB3RSTR;         /* Offset: 0x80  RCC APB3 peripheral reset register */
+  vu32 RESERVED6;
+  vu32 AHB1ENR;          /* Offset: 0x88  RCC AHB1 peripheral clock enable register */
+  vu32 AHB2ENR1;         /* Offset: 0x8C  RCC AHB2 peripheral clock enable register 1 */
+  vu32 AHB2ENR2;         /* Offset: 0x90  RCC AHB2 peripheral clock enable register 2 */
+  vu32 AHB3ENR;          /* Offset: 0x94  RCC AHB3 peripheral clock enable register */
+  vu32 RESERVED7[23];
+  vu32 CSR;              /* Offset: 0xF4  RCC control/status register */
+} RCC_TypeDef;
+
+// Power Control Registers
+typedef struct
+{
+  vu32 CR1;              /* Offset: 0x00  PWR control register 1 */
+  vu32 CR2;              /* Offset: 0x04  PWR control register 2 */
+  vu32 CR3;              /* Offset: 0x08  PWR control register 3 */
+  vu32 VOSR;             /* Offset: 0x0C  PWR voltage scaling register */
+} PWR_TypeDef;
+
 // Flash Registers
 typedef struct
 {
@@ -129,6 +212,7 @@ typedef struct
 #define FLASH_CR_MER1           ((u32)(  1U <<  2))
 #define FLASH_CR_PNB_MSK        ((u32)(0xFF <<  3))
 #define FLASH_CR_BKER           ((u32)(  1U << 11))
+#define FLASH_CR_BWR            ((u32)(  1U << 14))
 #define FLASH_CR_MER2           ((u32)(  1U << 15))
 #define FLASH_CR_STRT           ((u32)(  1U << 16))
 #define FLASH_CR_OPTSTRT        ((u32)(  1U << 17))
@@ -147,24 +231,178 @@ typedef struct
 #define FLASH_SR_OPTWERR        ((u32)(  1U << 13))
 #define FLASH_SR_BSY            ((u32)(  1U << 16))
 
+// Flash access control register definitions
+#define FLASH_ACR_LATENCY       ((u32)(0x0F      ))
+
 // Flash option register definitions
 #define FLASH_OPTR_RDP          ((u32)(0xFF      ))
 #define FLASH_OPTR_RDP_NO       ((u32)(0xAA      ))
 #define FLASH_OPTR_DBANK        ((u32)(  1U << 21))
+#define FLASH_OPTR_RDP_LEVEL2   ((u32)(0xCC      ))
 #define FLASH_OPTR_TZEN         ((u32)(  1U << 31))
 
+// Option bytes image: FLASH_OPTR .. FLASH_WRP2BR (12 words)
+#define FLASH_OPT_NUM           (12U)
+
+// Flash ECC register definitions
+#define FLASH_ECCR_ECCC         ((u32)(  1U << 30))
+#define FLASH_ECCR_ECCD         ((u32)(  1U << 31))
+
+
+// Debug Exception and Monitor Control register / DWT definitions
+#define DEMCR_TRCENA            ((u32)(  1U << 24))
+#define DWT_CTRL_CYCCNTENA      ((u32)(  1U      ))
+
+// RCC register definitions
+#define RCC_CR_PLL1ON           ((u32)(  1U << 24))
+#define RCC_CR_PLL1RDY          ((u32)(  1U << 25))
+#define RCC_CFGR1_SW            ((u32)(  3U      ))
+#define RCC_CFGR1_SW_PLL1       ((u32)(  3U      ))
+#define RCC_ICSCR1_MSIRGSEL     ((u32)(  1U << 23))
+#define RCC_CFGR1_SWS           ((u32)(  3U <<  2))
+#define RCC_CFGR1_SWS_MSIS      ((u32)(  0U <<  2))
+#define RCC_CFGR1_SWS_HSI16     ((u32)(  1U <<  2))
+#define RCC_CFGR1_SWS_PLL1      ((u32)(  3U <<  2))
+#define RCC_CFGR2_HPRE          ((u32)(0x0F      ))
+#define RCC_CFGR2_HPRE_DIV2     ((u32)(0x08      ))
+#define RCC_PLL1CFGR_SRC        ((u32)(  3U      ))
+#define RCC_PLL1CFGR_SRC_MSIS   ((u32)(  1U      ))
+#define RCC_PLL1CFGR_SRC_HSI16  ((u32)(  2U      ))
+#define RCC_PLL1CFGR_SRC_HSE    ((u32)(  3U      ))
+#define RCC_PLL1CFGR_REN        ((u32)(  1U << 18))
+#define RCC_AHB3ENR_PWREN       ((u32)(  1U <<  2))
+
+// PWR voltage scaling register definitions
+#define PWR_VOSR_BOOSTRDY       ((u32)(  1U << 14))
+#define PWR_VOSR_VOSRDY         ((u32)(  1U << 15))
+#define PWR_VOSR_VOS            ((u32)(  3U << 16))
+#define PWR_VOSR_VOS_RANGE1     ((u32)(  3U << 16))
+#define PWR_VOSR_BOOSTEN        ((u32)(  1U << 18))
+
 
 #define FLASH_PGERR             (FLASH_SR_OPERR  | FLASH_SR_PROGERR | FLASH_SR_WRPERR  | \
                                  FLASH_SR_PGAERR | FLASH_SR_SIZERR  | FLASH_SR_PGSERR  | FLASH_SR_OPTWERR)
 
-#if defined FLASH_MEM
-static u32 gFlashBase;                  /* Flash base address */
-static u32 gFlashSize;                  /* Flash size in bytes */
+// Flash programming granularity
+#define FLASH_QUADWORD_SIZE     (16U)           /* Quad-word size in bytes */
+#define FLASH_BURST_SIZE        (128U)          /* Burst size in bytes (8 quad-words) */
+
+// Sectors deferred by EraseSector for a bank mass erase
+#ifndef FLASH_ERASE_DEFER
+#define FLASH_ERASE_DEFER       (256U)          /* Max. pages of a bank collected for a mass erase */
+#endif
+
+// Operation timeouts in ms (DWT cycle counter based)
+#ifndef FLASH_TO_PROG
+#define FLASH_TO_PROG           (10U)           /* Quad-word / burst program */
+#endif
+#ifndef FLASH_TO_ERASE
+#define FLASH_TO_ERASE          (100U)          /* Page erase */
+#endif
+#ifndef FLASH_TO_MASS
+#define FLASH_TO_MASS           (10000U)        /* Bank / mass erase */
+#endif
+#ifndef FLASH_TO_FLUSH
+#define FLASH_TO_FLUSH          (2500U)         /* Deferred page erases in one call (FlashDev.c timeouts 3 s) */
+#endif
+#ifndef FLASH_TO_IDLE
+#define FLASH_TO_IDLE           (10000U)        /* Pending operation (Init, UnInit) */
+#endif
+#ifndef FLASH_TO_CLK
+#define FLASH_TO_CLK            (10U)           /* Voltage range, booster, PLL1, clock switch */
+#endif
+
+// Core clock when the algorithm runs (cycles per ms)
+#define CLK_HSI16_KHZ           (16000U)        /* HSI16 */
+#define CLK_MSIS_KHZ            (4000U)         /* MSIS after reset */
+#ifndef HSE_VALUE
+#define HSE_VALUE               (16000000U)     /* HSE crystal/clock in Hz (board specific) */
+#endif
+#define CLK_HSE_KHZ             (HSE_VALUE / 1000U)
+#define CLK_BOOST_KHZ           (160000U)       /* PLL1 160 MHz (FLASH_CLK_BOOST) */
+
+// Cycle statistic of one operation type
+typedef struct {
+  u32 last;                             /* Cycles of last operation */
+  u32 max;                              /* Max. cycles */
+  u32 sum;                              /* Sum of cycles */
+  u32 cnt;                              /* Number of operations */
+} FLASH_TIMING_OP;
 
-static vu32 *pFlashCR;                  /* Pointer to Flash Control register */
-static vu32 *pFlashSR;                  /* Pointer to Flash Status register */
+// Timing record, kept in algorithm RAM (read by debugger after a session)
+typedef struct {
+  u32             clkKHz;               /* Core clock in kHz (cycles per ms) */
+  u32             init;                 /* Cycles of last Init */
+  FLASH_TIMING_OP erase;                /* Page / bank / mass erase */
+  FLASH_TIMING_OP prog;                 /* Quad-word or burst program */
+  u32             timeouts;             /* Number of timed out operations */
+} FLASH_TIMING;
+
+FLASH_TIMING gFlashTiming;
+
+#if defined FLASH_OPT
+static u32 gOptBase;                    /* Option bytes image base address */
+static u32 gOptChanged;                 /* Option registers written, OPTSTRT pending */
+
+/* Writable bits of FLASH_OPTR .. FLASH_WRP2BR */
+static const u32 gOptMask[FLASH_OPT_NUM] = {
+  0xFFFFF7FF,                           /* OPTR */
+  0xFFFFFF80,                           /* NSBOOTADD0R */
+  0xFFFFFF80,                           /* NSBOOTADD1R */
+  0xFFFFFF81,                           /* SECBOOTADD0R */
+  0x00FF00FF,                           /* SECWM1R1 */
+  0x80FF0000,                           /* SECWM1R2 */
+  0x80FF00FF,                           /* WRP1AR */
+  0x80FF00FF,                           /* WRP1BR */
+  0x00FF00FF,                           /* SECWM2R1 */
+  0x80FF0000,                           /* SECWM2R2 */
+  0x80FF00FF,                           /* WRP2AR */
+  0x80FF00FF                            /* WRP2BR */
+};
+#endif /* FLASH_OPT */
+
+#if defined FLASH_MEM
+// Flash geometry, decoded once in Init
+typedef struct {
+  u32   base;                           /* Flash base address */
+  u32   size;                           /* Flash size in bytes */
+  u32   bankSize;                       /* Flash bank size in bytes (= size in Single-Bank mode) */
+  u32   bankShift;                      /* log2(bankSize): address offset >> bankShift = bank number */
+  u32   pageShift;                      /* log2(page size) */
+  u32   dualBank;                       /* 0 = Single-Bank mode, 1 = Dual-Bank mode */
+  vu32 *pCR;                            /* Pointer to Flash Control register (NSCR/SECCR) */
+  vu32 *pSR;                            /* Pointer to Flash Status register (NSSR/SECSR) */
+} FLASH_GEOMETRY;
+
+static FLASH_GEOMETRY gFlash;
+
+static u32 gEraseStart;                 /* Start of pending sector erase range */
+static u32 gEraseEnd;                   /* End of pending sector erase range */
+
+static int EraseFlush (void);
+
+// Vector table used while Flash is read (catches the ECCD NMI)
+#define VECT_NUM                (16U)           /* System exceptions */
+static u32  gVectBuf[VECT_NUM + 32U];           /* Room to align the table to 128 bytes */
+static vu32 gEccd;                              /* Double ECC error detected (NMI) */
 #endif /* FLASH_MEM */
 
+#if defined FLASH_MEM && defined FLASH_CLK_BOOST
+// Clock configuration saved by ClockBoost, restored by ClockRestore
+typedef struct {
+  u32 active;                           /* 1 = SYSCLK boosted by algorithm */
+  u32 ahb3enr;
+  u32 vosr;
+  u32 acr;
+  u32 cfgr1;
+  u32 cfgr2;
+  u32 pll1cfgr;
+  u32 pll1divr;
+} CLOCK_STATE;
+
+static CLOCK_STATE gClock;
+#endif /* FLASH_MEM && FLASH_CLK_BOOST */
+
 static void DSB(void) {
   __asm("DSB");
 }
@@ -174,6 +412,114 @@ static void NOP(void) {
 }
 
 
+/*
+ * Start DWT Cycle Counter
+ */
+
+static void TimerInit (void) {
+  DEMCR     |= DEMCR_TRCENA;                             /* Enable DWT */
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA;                       /* Enable cycle counter */
+}
+
+
+/*
+ * Get DWT Cycle Counter
+ *    Return Value:   cycle count (wraps around)
+ */
+
+static u32 TimerGet (void) {
+  return (DWT->CYCCNT);
+}
+
+
+/*
+ * Update Timing Statistic
+ *    Parameter:      op:     Timing record of operation type
+ *                    start:  Cycle count at start of operation
+ */
+
+static void TimingAdd (FLASH_TIMING_OP *op, u32 start) {
+  u32 cycles = TimerGet() - start;
+
+  op->last  = cycles;
+  op->sum  += cycles;
+  op->cnt  += 1U;
+  if (cycles > op->max) {
+    op->max = cycles;
+  }
+}
+
+
+/*
+ * Get Core Clock (HCLK) from the RCC configuration
+ *    Return Value:   Core clock in kHz (cycles per ms)
+ *    Note:           The clock left by the application or a debugger script is used.
+ *                    HSE frequency is taken from HSE_VALUE (define it for the board).
+ */
+
+static u32 GetCoreClockKHz (void) {
+  static const u32 msiRangeKHz[16] = { 48000U, 24000U, 16000U, 12000U, 4000U, 2000U, 1330U, 1000U,
+                                        3072U,  1536U,  1024U,   768U,  400U,  200U,  133U,  100U };
+  static const unsigned char ahbPrescShift[16] = { 0U, 0U, 0U, 0U, 0U, 0U, 0U, 0U, 1U, 2U, 3U, 4U, 6U, 7U, 8U, 9U };
+  u32 msi, clk;
+
+  if (RCC->ICSCR1 & RCC_ICSCR1_MSIRGSEL) {
+    msi = msiRangeKHz[(RCC->ICSCR1 >> 28) & 0x0F];       /* MSISRANGE from RCC_ICSCR1 */
+  } else {
+    msi = msiRangeKHz[(RCC->CSR    >> 12) & 0x0F];       /* MSISSRANGE from RCC_CSR (after reset) */
+  }
+
+  switch (RCC->CFGR1 & RCC_CFGR1_SWS) {
+    case RCC_CFGR1_SWS_MSIS:
+      clk = msi;
+      break;
+    case RCC_CFGR1_SWS_HSI16:
+      clk = CLK_HSI16_KHZ;
+      break;
+    case RCC_CFGR1_SWS_PLL1:
+      switch (RCC->PLL1CFGR & RCC_PLL1CFGR_SRC) {
+        case RCC_PLL1CFGR_SRC_MSIS:  clk = msi;           break;
+        case RCC_PLL1CFGR_SRC_HSI16: clk = CLK_HSI16_KHZ; break;
+        case RCC_PLL1CFGR_SRC_HSE:   clk = CLK_HSE_KHZ;   break;
+        default:                     return (CLK_MSIS_KHZ);  /* No PLL1 source */
+      }
+      clk  = clk / (((RCC->PLL1CFGR >>  8) & 0x0F) + 1U);  /* PLL1 input / M */
+      clk *= ((RCC->PLL1DIVR       & 0x1FF) + 1U);       /* VCO = input * N */
+      clk /= (((RCC->PLL1DIVR >> 24) & 0x7F) + 1U);      /* PLL1R = VCO / R */
+      break;
+    default:                                             /* HSE */
+      clk = CLK_HSE_KHZ;
+      break;
+  }
+
+  clk >>= ahbPrescShift[RCC->CFGR2 & RCC_CFGR2_HPRE];    /* AHB prescaler */
+
+  return ((clk != 0U) ? clk : CLK_MSIS_KHZ);
+}
+
+
+/*
+ * Wait until Flash operation is finished
+ *    Parameter:      sr:     Flash Status register
+ *                    start:  Cycle count at start of operation
+ *                    to:     Timeout (in ms)
+ *    Return Value:   0 - OK,  1 - Timeout
+ */
+
+static int WaitBusy (vu32 *sr, u32 start, u32 to) {
+  u32 limit = to * gFlashTiming.clkKHz;
+
+  while (*sr & FLASH_SR_BSY) {
+    if ((TimerGet() - start) > limit) {
+      gFlashTiming.timeouts++;
+      return (1);                                        /* Timeout */
+    }
+  }
+
+  return (0);
+}
+
+
 /*
  * Get Flash security Mode
  *    Return Value:   0 = non-secure Flash
@@ -189,30 +535,6 @@ static u32 GetFlashSecureMode (void) {
 }
 
 
-/*
- * Get Flash Type
- *    Return Value:   0 = Single-Bank flash
- *                    1 = Dual-Bank Flash (configurable)
- */
-
-#if defined FLASH_MEM
-static u32 GetFlashType (void) {
-//  u32 flashType = 0U;
-//
-//  switch ((DBGMCU->IDCODE & 0xFFFU))
-//  {
-//    case 0x482:             /* Flash Category ? devices, 8k sectors (STM32U575/585) */
-//    default:                /* devices have a dual bank flash, configurable via FLASH_OPTR.DBANK */
-//      flashType = 1U;       /* Dual-Bank Flash type */
-//    break;
-//  }
-//
-//  return (flashType);
-  return (1U);              /* always Dual-Bank Flash */
-}
-#endif /* FLASH_MEM */
-
-
 /*
  * Get Flash Bank Mode
  *    Return Value:   0 = Single-Bank mode
@@ -234,41 +556,11 @@ static u32 GetFlashBankMode (void) {
  * Get Flash Bank Number
  *    Parameter:      adr:  Sector Address
  *    Return Value:   Bank Number (0..1)
- *                    Flash bank size is always the half of the Flash size
  */
 
 #if defined FLASH_MEM
-static u32 GetFlashBankNum(u32 adr) {
-  u32 flashBankNum;
-
-  if (GetFlashType() == 1U)
-  {
-    /* Dual-Bank Flash */
-    if (GetFlashBankMode() == 1U)
-    {
-      /* Dual-Bank Flash configured as Dual-Bank */
-      if (adr >= (gFlashBase + (gFlashSize >> 1)))
-      {
-        flashBankNum = 1U;
-      }
-      else
-      {
-        flashBankNum = 0U;
-      }
-    }
-    else
-    {
-      /* Dual-Bank Flash configured as Single-Bank */
-      flashBankNum = 0U;
-    }
-  }
-  else
-  {
-    /* Single-Bank Flash */
-    flashBankNum = 0U;
-  }
-
-  return (flashBankNum);
+static u32 GetFlashBankNum (u32 adr) {
+  return ((adr - gFlash.base) >> gFlash.bankShift);
 }
 #endif /* FLASH_MEM */
 
@@ -280,67 +572,167 @@ static u32 GetFlashBankNum(u32 adr) {
  */
 
 #if defined FLASH_MEM
-static u32 GetFlashPageNum (unsigned long adr) {
-  u32 flashPageNum;
+static u32 GetFlashPageNum (u32 adr) {
+  return (((adr - gFlash.base) & (gFlash.bankSize - 1U)) >> gFlash.pageShift);
+}
+#endif /* FLASH_MEM */
 
-  if (GetFlashType() == 1U)
-  {
-    /* Dual-Bank Flash */
-    if (GetFlashBankMode() == 1U)
-    {
-      /* Dual-Bank Flash configured as Dual-Bank */
-      flashPageNum = (((adr & ((gFlashSize >> 1) - 1U)) ) >> 13); /* 8K sector size */
-    }
-    else
-    {
-      /* Dual-Bank Flash configured as Single-Bank */
-      flashPageNum = (((adr & (gFlashSize        - 1U)) ) >> 13); /* 8K sector size */
+
+/*
+ * Decode Flash Geometry
+ *    Parameter:      adr:  Device Base Address
+ *    Note:           Flash size is always a power of two, bank size is the half
+ *                    of the Flash size in Dual-Bank mode.
+ */
+
+#if defined FLASH_MEM
+static void InitFlashGeometry (u32 adr) {
+  u32 shift;
+
+  gFlash.base      = adr;
+  gFlash.size      = (M32(FLASHSIZE_BASE) & 0x0000FFFF) << 10;
+  gFlash.dualBank  = GetFlashBankMode();
+  gFlash.pageShift = 13U;                                /* 8K sector size */
+
+  for (shift = 0U; (1UL << shift) < gFlash.size; shift++);
+  gFlash.bankShift = shift - gFlash.dualBank;
+  gFlash.bankSize  = (1UL << gFlash.bankShift);
+}
+#endif /* FLASH_MEM */
+
+
+/*
+ * Wait until Register Bits have the expected Value
+ *    Parameter:      reg:    Register
+ *                    msk:    Bit mask
+ *                    val:    Expected value of the masked bits
+ *                    to:     Timeout (in ms)
+ *    Return Value:   0 - OK,  1 - Timeout
+ */
+
+#if defined FLASH_MEM && defined FLASH_CLK_BOOST
+static int WaitReg (vu32 *reg, u32 msk, u32 val, u32 to) {
+  u32 start = TimerGet();
+  u32 limit = to * gFlashTiming.clkKHz;
+
+  while ((*reg & msk) != val) {
+    if ((TimerGet() - start) > limit) {
+      gFlashTiming.timeouts++;
+      return (1);                                        /* Timeout */
     }
   }
-  else
-  {
-      /* Single-Bank Flash */
-      flashPageNum = (((adr & (gFlashSize        - 1U)) ) >> 13); /* 8K sector size */
+
+  return (0);
+}
+#endif /* FLASH_MEM && FLASH_CLK_BOOST */
+
+
+/*
+ * Restore System Clock configuration saved by ClockBoost
+ *    Return Value:   0 - OK,  1 - Timeout
+ *    Note:           Also undoes a partly done ClockBoost.
+ */
+
+#if defined FLASH_MEM && defined FLASH_CLK_BOOST
+static int ClockRestore (void) {
+  int rc = 0;
+
+  if (gClock.active == 0U) {
+    return (0);
   }
+  gClock.active = 0U;
+
+  RCC->CFGR1 = gClock.cfgr1;                             /* Back to MSIS */
+  rc |= WaitReg(&RCC->CFGR1, RCC_CFGR1_SWS, 0U, FLASH_TO_CLK);
+  RCC->CFGR2 = gClock.cfgr2;
+
+  RCC->CR &= ~RCC_CR_PLL1ON;                             /* Disable PLL1 */
+  rc |= WaitReg(&RCC->CR, RCC_CR_PLL1RDY, 0U, FLASH_TO_CLK);
+  RCC->PLL1CFGR = gClock.pll1cfgr;
+  RCC->PLL1DIVR = gClock.pll1divr;
 
-  return (flashPageNum);
+  FLASH->ACR = gClock.acr;                               /* Restore wait states */
+  PWR->VOSR  = gClock.vosr;                              /* Restore voltage range / booster */
+  RCC->AHB3ENR = gClock.ahb3enr;
+
+  return (rc);
 }
-#endif /* FLASH_MEM */
+#endif /* FLASH_MEM && FLASH_CLK_BOOST */
 
 
 /*
- * Get Flash Page Size
- *    Return Value:   flash page size (in Bytes)
+ * Boost System Clock to 160 MHz (PLL1 from MSIS 4 MHz)
+ *    Note:           Only done when running from MSIS with PLL1 off (reset state).
+ *                    Voltage range 1, EPOD booster and 4 Flash wait states are set
+ *                    before switching, the previous state is kept for ClockRestore.
+ *                    A step that times out is undone and the clock stays at MSIS.
  */
 
-#if 0 //defined FLASH_MEM
-static u32 GetFlashPageSize (void)
-{
-  u32 flashPageSize;
+#if defined FLASH_MEM && defined FLASH_CLK_BOOST
+static void ClockBoost (void) {
+  u32 n;
 
-  if (GetFlashType() == 1U)
-  {
-    /* Dual-Bank Flash */
-    if (GetFlashBankMode() == 1U)
-    {
-      /* Dual-Bank Flash configured as Dual-Bank */
-      flashPageSize = 0x2000;                            /* 8K sector size */
-    }
-    else
-    {
-      /* Dual-Bank Flash configured as Single-Bank */
-      flashPageSize = 0x2000;                            /* 8K sector size */
-    }
+  gClock.active = 0U;
+
+  if (((RCC->CFGR1 & RCC_CFGR1_SWS) != 0U) ||            /* SYSCLK not MSIS */
+      ((RCC->CR & RCC_CR_PLL1ON)    != 0U)   ) {         /* PLL1 already in use */
+    return;                                              /* Keep clock configuration */
   }
-  else
-  {
-    /* Single-Bank Flash */
-      flashPageSize = 0x2000;                            /* 8K sector size */
+
+  gClock.ahb3enr  = RCC->AHB3ENR;
+  gClock.vosr     = PWR->VOSR;
+  gClock.acr      = FLASH->ACR;
+  gClock.cfgr1    = RCC->CFGR1;
+  gClock.cfgr2    = RCC->CFGR2;
+  gClock.pll1cfgr = RCC->PLL1CFGR;
+  gClock.pll1divr = RCC->PLL1DIVR;
+  gClock.active   = 1U;                                  /* ClockRestore undoes any step below */
+
+  RCC->AHB3ENR = gClock.ahb3enr | RCC_AHB3ENR_PWREN;     /* Enable PWR clock */
+  (void)RCC->AHB3ENR;
+
+  PWR->VOSR = (gClock.vosr & ~PWR_VOSR_VOS) | PWR_VOSR_VOS_RANGE1;
+  if (WaitReg(&PWR->VOSR, PWR_VOSR_VOSRDY, PWR_VOSR_VOSRDY, FLASH_TO_CLK)) {
+    (void)ClockRestore();                                /* Voltage range 1 not reached */
+    return;
   }
 
-  return (flashPageSize);
+  FLASH->ACR = (gClock.acr & ~FLASH_ACR_LATENCY) | 4U;   /* 4 wait states for 160 MHz */
+  if (WaitReg(&FLASH->ACR, FLASH_ACR_LATENCY, 4U, FLASH_TO_CLK)) {
+    (void)ClockRestore();
+    return;
+  }
+
+  RCC->PLL1CFGR = (RCC_PLL1CFGR_SRC_MSIS |               /* MSIS 4 MHz, M = 1, MBOOST = 1, 4..8 MHz input */
+                   RCC_PLL1CFGR_REN       );             /* Enable PLL1 R output (SYSCLK) */
+  RCC->PLL1DIVR = ((80U - 1U)       |                    /* N = 80: VCO 320 MHz */
+                   ((2U - 1U) <<  9) |                   /* P = 2 */
+                   ((2U - 1U) << 16) |                   /* Q = 2 */
+                   ((2U - 1U) << 24)  );                 /* R = 2: 160 MHz */
+
+  PWR->VOSR |= PWR_VOSR_BOOSTEN;                         /* Enable EPOD booster */
+  if (WaitReg(&PWR->VOSR, PWR_VOSR_BOOSTRDY, PWR_VOSR_BOOSTRDY, FLASH_TO_CLK)) {
+    (void)ClockRestore();
+    return;
+  }
+
+  RCC->CR |= RCC_CR_PLL1ON;                              /* Enable PLL1 */
+  if (WaitReg(&RCC->CR, RCC_CR_PLL1RDY, RCC_CR_PLL1RDY, FLASH_TO_CLK)) {
+    (void)ClockRestore();                                /* PLL1 not locked */
+    return;
+  }
+
+  RCC->CFGR2 = (gClock.cfgr2 & ~RCC_CFGR2_HPRE) | RCC_CFGR2_HPRE_DIV2;  /* Transition via AHB / 2 */
+  RCC->CFGR1 = (gClock.cfgr1 & ~RCC_CFGR1_SW) | RCC_CFGR1_SW_PLL1;
+  if (WaitReg(&RCC->CFGR1, RCC_CFGR1_SWS, RCC_CFGR1_SWS_PLL1, FLASH_TO_CLK)) {
+    (void)ClockRestore();                                /* Switch to PLL1 failed */
+    return;
+  }
+
+  for (n = 100U; n != 0U; n--) NOP();                    /* Wait at least 1 us */
+  RCC->CFGR2 = (gClock.cfgr2 & ~RCC_CFGR2_HPRE);         /* AHB / 1: HCLK 160 MHz */
 }
-#endif /* FLASH_MEM */
+#endif /* FLASH_MEM && FLASH_CLK_BOOST */
 
 
 /*
@@ -353,35 +745,45 @@ static u32 GetFlashPageSize (void)
 
 int Init (unsigned long adr, unsigned long clk, unsigned long fnc)
 {
+  u32 start;
+
   (void)clk;
   (void)fnc;
 
 	 __disable_irq();
 
+  TimerInit();
+  start = TimerGet();
+  gFlashTiming.clkKHz = GetCoreClockKHz();
+
 #if defined FLASH_MEM
   if (GetFlashSecureMode() == 0U)
   {                                                      /* Flash non-secure */
     /* set used Control, Status register */
-    pFlashCR = &FLASH->NSCR;
-    pFlashSR = &FLASH->NSSR;
+    gFlash.pCR = &FLASH->NSCR;
+    gFlash.pSR = &FLASH->NSSR;
 
     /* unlock FLASH_NSCR */
     FLASH->NSKEYR = FLASH_KEY1;
     FLASH->NSKEYR = FLASH_KEY2;
     DSB();
-    while (FLASH->NSSR & FLASH_SR_BSY) NOP();            /* Wait until operation is finished */
+    if (WaitBusy(&FLASH->NSSR, start, FLASH_TO_IDLE)) {  /* Wait until operation is finished */
+      return (1);                                        /* Failed */
+    }
   }
   else
   {                                                      /* Flash secure */
     /* set used Control, Status register */
-    pFlashCR = &FLASH->SECCR;
-    pFlashSR = &FLASH->SECSR;
+    gFlash.pCR = &FLASH->SECCR;
+    gFlash.pSR = &FLASH->SECSR;
 
     /* unlock FLASH_SECCR */
     FLASH->SECKEYR = FLASH_KEY1;
     FLASH->SECKEYR = FLASH_KEY2;
     DSB();
-    while (FLASH->SECSR & FLASH_SR_BSY) NOP();           /* Wait until operation is finished */
+    if (WaitBusy(&FLASH->SECSR, start, FLASH_TO_IDLE)) { /* Wait until operation is finished */
+      return (1);                                        /* Failed */
+    }
 
     /* Flash block-based secure bank1 */
     FLASH->SECBB1R1 = 0xFFFFFFFF;
@@ -399,33 +801,44 @@ int Init (unsigned long adr, unsigned long clk, unsigned long fnc)
     }
   }
 
-  while (*pFlashSR & FLASH_SR_BSY) NOP();                /* Wait until operation is finished */
+  if (WaitBusy(gFlash.pSR, start, FLASH_TO_IDLE)) {     /* Wait until operation is finished */
+    return (1);                                          /* Failed */
+  }
+
+  InitFlashGeometry(adr);
+  gEraseStart = gEraseEnd = 0U;
 
-  gFlashBase = adr;
-  gFlashSize = (M32(FLASHSIZE_BASE) & 0x0000FFFF) << 10;
+#if defined FLASH_CLK_BOOST
+  ClockBoost();                                          /* SYSCLK 160 MHz for this session */
+  if (gClock.active != 0U) {
+    gFlashTiming.clkKHz = CLK_BOOST_KHZ;
+  }
+#endif /* FLASH_CLK_BOOST */
 #endif /* FLASH_MEM */
 
 #if defined FLASH_OPT
-  (void)adr;
+  gOptBase    = adr;
+  gOptChanged = 0U;
 
   /* unlock FLASH_NSCR */
   FLASH->NSKEYR = FLASH_KEY1;
   FLASH->NSKEYR = FLASH_KEY2;
   DSB();
-  while (FLASH->NSSR & FLASH_SR_BSY) NOP();              /* Wait until operation is finished */
+  if (WaitBusy(&FLASH->NSSR, start, FLASH_TO_IDLE)) {    /* Wait until operation is finished */
+    return (1);                                          /* Failed */
+  }
 
   /* Unlock Option Bytes operation */
   FLASH->OPTKEYR = FLASH_OPTKEY1;
   FLASH->OPTKEYR = FLASH_OPTKEY2;
   DSB();
-  while (FLASH->NSSR & FLASH_SR_BSY) NOP();              /* Wait until operation is finished */
-
-  /* load option bytes */
-//FLASH->NSCR = FLASH_CR_OBL_LAUNCH;
-//DSB();
-//while (FLASH->NSCR & FLASH_CR_OBL_LAUNCH);             /* Wait until option bytes are updated */
+  if (WaitBusy(&FLASH->NSSR, start, FLASH_TO_IDLE)) {    /* Wait until operation is finished */
+    return (1);                                          /* Failed */
+  }
 #endif /* FLASH_OPT */
 
+  gFlashTiming.init = TimerGet() - start;
+
   return (0);
 }
 
@@ -438,34 +851,118 @@ int Init (unsigned long adr, unsigned long clk, unsigned long fnc)
 
 int UnInit (unsigned long fnc)
 {
+  int rc = 0;
+
   (void)fnc;
 
 #if defined FLASH_MEM
+  rc = EraseFlush();                                     /* Erase pending sectors */
+
   /* Lock Flash operation */
-  *pFlashCR = FLASH_CR_LOCK;
+  *gFlash.pCR = FLASH_CR_LOCK;
   DSB();
-  while (*pFlashSR & FLASH_SR_BSY) NOP();                /* Wait until operation is finished */
+  rc |= WaitBusy(gFlash.pSR, TimerGet(), FLASH_TO_IDLE); /* Wait until operation is finished */
+
+#if defined FLASH_CLK_BOOST
+  rc |= ClockRestore();                                  /* Restore reset clock configuration */
+#endif /* FLASH_CLK_BOOST */
 #endif /* FLASH_MEM */
 
 #if defined FLASH_OPT
+  if (gOptChanged != 0U)
+  {                                                      /* Program all staged option bytes at once */
+    rc = WaitBusy(&FLASH->NSSR, TimerGet(), FLASH_TO_IDLE);
+    if (rc == 0) {
+      FLASH->NSSR  = FLASH_PGERR;                        /* Reset Error Flags */
+      FLASH->NSCR |= FLASH_CR_OPTSTRT;                   /* Start option bytes programming */
+      DSB();
+      rc = WaitBusy(&FLASH->NSSR, TimerGet(), FLASH_TO_MASS);
+      if ((rc == 0) && (FLASH->NSSR & FLASH_PGERR)) {    /* Check for Error */
+        FLASH->NSSR = FLASH_PGERR;                       /* Reset Error Flags */
+        rc = 1;                                          /* Failed */
+      }
+    }
+    gOptChanged = 0U;
+  }
+
+  /* New option bytes are loaded by OBL_LAUNCH (debug variable DoOptionByteLoading)
+     or by the next power-on reset */
+
   /* Lock option bytes operation */
   FLASH->NSCR = FLASH_CR_OPTLOCK;
   DSB();
-  while (FLASH->NSCR & FLASH_SR_BSY) NOP();              /* Wait until operation is finished */
-
-  /* Load option bytes */
-//FLASH->NSCR  = FLASH_CR_OBL_LAUNCH;
-//DSB();
-//while (FLASH->NSCR & FLASH_CR_OBL_LAUNCH);             /* Wait until option bytes are updated */
+  rc |= WaitBusy(&FLASH->NSSR, TimerGet(), FLASH_TO_IDLE); /* Wait until operation is finished */
 
   /* Lock FLASH CR */
   FLASH->NSCR = FLASH_CR_LOCK;
   DSB();
-  while (FLASH->NSCR & FLASH_SR_BSY) NOP();              /* Wait until operation is finished */
+  rc |= WaitBusy(&FLASH->NSSR, TimerGet(), FLASH_TO_IDLE); /* Wait until operation is finished */
 #endif /* FLASH_OPT */
 
-  return (0);
+  return (rc);
+}
+
+
+/*
+ * NMI Handler used while Flash is read
+ *    Note:           ECCD raises the NMI, it cannot be masked. The error is
+ *                    recorded and the read continues.
+ */
+
+#if defined FLASH_MEM
+static void EccNmiHandler (void) {
+  FLASH->ECCR = FLASH_ECCR_ECCD;                         /* Reset ECC detection Flag */
+  gEccd = 1U;
+}
+#endif /* FLASH_MEM */
+
+
+/*
+ * Start catching ECC errors of Flash reads
+ *    Return Value:   previous VTOR
+ */
+
+#if defined FLASH_MEM
+static u32 EccGuardOn (void) {
+  u32 *vt  = (u32 *)(((u32)gVectBuf + 127U) & ~127U);   /* VTOR needs 128 byte alignment */
+  u32  vtor = SCB_VTOR;
+  u32  n;
+
+  for (n = 0U; n < VECT_NUM; n++) {
+    vt[n] = M32(vtor + (n << 2));                        /* Keep the other handlers */
+  }
+  vt[2] = (u32)EccNmiHandler;                            /* NMI */
+
+  FLASH->ECCR = (FLASH_ECCR_ECCC | FLASH_ECCR_ECCD);     /* Reset ECC Flags */
+  gEccd = 0U;
+  SCB_VTOR = (u32)vt;
+  DSB();
+
+  return (vtor);
+}
+#endif /* FLASH_MEM */
+
+
+/*
+ * Stop catching ECC errors of Flash reads
+ *    Parameter:      vtor:  VTOR returned by EccGuardOn
+ *    Return Value:   0 - no ECC event,  1 - ECC error corrected (ECCC) or detected (ECCD)
+ */
+
+#if defined FLASH_MEM
+static int EccGuardOff (u32 vtor) {
+  int rc;
+
+  DSB();                                                 /* Take a pending NMI */
+  rc = ((gEccd != 0U) || (FLASH->ECCR & FLASH_ECCR_ECCC)) ? 1 : 0;
+
+  SCB_VTOR = vtor;
+  FLASH->ECCR = FLASH_ECCR_ECCC;                         /* Reset ECC correction Flag */
+  DSB();
+
+  return (rc);
 }
+#endif /* FLASH_MEM */
 
 
 /*
@@ -476,90 +973,239 @@ int UnInit (unsigned long fnc)
  *    Return Value:   0 - OK,  1 - Failed
  */
 
+#if defined FLASH_MEM
 int BlankCheck (unsigned long adr, unsigned long sz, unsigned char pat) {
-  /* For OPT algorithm Flash is always erased */
+  const vu32 *p = (const vu32 *)adr;
+  u32 pat32;
+  u32 val;
+  u32 vtor;
+  int rc = 0;
+
+  /* Only a erased quad-word can be programmed (ECC). Erased quad-words read as
+     'Initial Content of Erased Memory' without any ECC event, a corrected single
+     bit error (ECCC) marks a programmed quad-word. A double ECC error (ECCD) is
+     caught by EccNmiHandler and reports 'not blank', so the sector is erased.
+     Note: A quad-word programmed with the erased pattern cannot be told apart
+           (ProgramPage never programs such quad-words). */
+  pat32 = (u32)pat * 0x01010101U;                        /* Pattern as word */
+
+  FLASH->ECCR = FLASH_ECCR_ECCC;                         /* Reset ECC correction Flag (also on early exits) */
+
+  if ((pat == 0xFF) && (adr >= gEraseStart) && ((adr + sz) <= gEraseEnd)) {
+    return (0);                                          /* Erase pending for complete range, nothing read */
+  }
+  if ((adr < gEraseEnd) && ((adr + sz) > gEraseStart)) {
+    if (EraseFlush() != 0) {                             /* Range overlaps pending erase */
+      return (1);                                        /* Failed, nothing read */
+    }
+  }
 
-  (void)adr;
-  (void)sz;
-  (void)pat;
+  vtor = EccGuardOn();
 
-#if defined FLASH_MEM
-  /* force erase even if the content is 'Initial Content of Erased Memory'.
-     Only a erased sector can be programmed. I think this is because of ECC */
-  return (1);
+  while (sz >= FLASH_QUADWORD_SIZE) {
+    val  = (*p++ ^ pat32);                               /* Read complete quad-word */
+    val |= (*p++ ^ pat32);
+    val |= (*p++ ^ pat32);
+    val |= (*p++ ^ pat32);
+    if (val != 0U) {                                     /* Check quad-word */
+      rc = 1;                                            /* Not blank */
+      break;
+    }
+    sz -= FLASH_QUADWORD_SIZE;
+  }
+
+  adr = (u32)p;
+  while ((rc == 0) && (sz != 0U)) {                      /* Check remaining bytes */
+    if (M8(adr) != pat) {
+      rc = 1;                                            /* Not blank */
+    }
+    adr++;
+    sz--;
+  }
+
+  if (EccGuardOff(vtor) != 0) {                          /* ECC event: programmed or damaged */
+    rc = 1;                                              /* Not blank */
+  }
+
+  return (rc);
+}
 #endif /* FLASH_MEM */
 
 #if defined FLASH_OPT
+int BlankCheck (unsigned long adr, unsigned long sz, unsigned char pat) {
+
+  (void)adr;
+  (void)sz;
+  (void)pat;
+
   /* For OPT algorithm Flash is always erased */
   return (0);
-#endif /* FLASH_OPT */
 }
+#endif /* FLASH_OPT */
 
 
 /*
- *  Erase complete Flash Memory
+ *  Execute Erase Operation
+ *    Parameter:      cr:   Erase Control Bits (PER/PNB/BKER or MER1/MER2)
  *    Return Value:   0 - OK,  1 - Failed
  */
 
 #if defined FLASH_MEM
-int EraseChip (void)
+static int EraseExec (u32 cr)
 {
-  *pFlashSR = FLASH_PGERR;                               /* Reset Error Flags */
+  int rc = 0;
+  u32 start;
+
+  if (WaitBusy(gFlash.pSR, TimerGet(), FLASH_TO_IDLE)) { /* Wait until operation is finished */
+    return (1);                                          /* Failed */
+  }
 
-  *pFlashCR  = (FLASH_CR_MER1 | FLASH_CR_MER2);          /* Bank A/B mass erase enabled */
-  *pFlashCR |=  FLASH_CR_STRT;                           /* Start erase */
+  *gFlash.pSR  = FLASH_PGERR;                            /* Reset Error Flags */
+
+  start = TimerGet();
+  *gFlash.pCR  = cr;                                     /* Select erase operation */
+  *gFlash.pCR |= FLASH_CR_STRT;                          /* Start Erase */
   DSB();
 
-  while (*pFlashSR & FLASH_SR_BSY) NOP();                /* Wait until operation is finished */
+  if (WaitBusy(gFlash.pSR, start, (cr & FLASH_CR_PER) ? FLASH_TO_ERASE : FLASH_TO_MASS)) {
+    return (1);                                          /* Timeout */
+  }
+  TimingAdd(&gFlashTiming.erase, start);
 
-  return (0);                                            /* Done */
+  if (*gFlash.pSR & FLASH_PGERR) {                       /* Check for Error */
+    *gFlash.pSR  = FLASH_PGERR;                          /* Reset Error Flags */
+    rc = 1;                                              /* Failed */
+  }
+
+  *gFlash.pCR = 0U;                                      /* Reset CR */
+
+  return (rc);
+}
+#endif /* FLASH_MEM */
+
+
+/*
+ *  Erase complete Flash Memory
+ *    Return Value:   0 - OK,  1 - Failed
+ */
+
+#if defined FLASH_MEM
+int EraseChip (void)
+{
+  gEraseStart = gEraseEnd = 0U;                          /* Pending sectors are erased as well */
+
+  return (EraseExec(FLASH_CR_MER1 | FLASH_CR_MER2));     /* Bank A/B mass erase */
 }
 #endif /* FLASH_MEM */
 
 #ifdef FLASH_OPT
 int EraseChip (void) {
 
-  /* not yet coded */
+  /* Option bytes are not erased, ProgramPage writes the complete image */
   return (0);                                            /* Done */
 }
 #endif /* FLASH_OPT */
 
 
 /*
- *  Erase Sector in Flash Memory
- *    Parameter:      adr:  Sector Address
+ *  Erase Page in Flash Memory
+ *    Parameter:      adr:  Page Address
  *    Return Value:   0 - OK,  1 - Failed
  */
 
 #if defined FLASH_MEM
-int EraseSector (unsigned long adr)
+static int ErasePage (u32 adr)
 {
   u32 b, p;
 
   b = GetFlashBankNum(adr);                              /* Get Bank Number 0..1  */
-  p = GetFlashPageNum(adr);                              /* Get Page Number 0..127 */
+  p = GetFlashPageNum(adr);                              /* Get Page Number 0..255 */
 
-  while (*pFlashSR & FLASH_SR_BSY) NOP();                /* Wait until operation is finished */
+  return (EraseExec(FLASH_CR_PER |                       /* Page Erase Enabled */
+                    (p <<  3)    |                       /* page Number. 0 to 255 for each bank */
+                    (b << 11)     ));                    /* Bank selection */
+}
+#endif /* FLASH_MEM */
 
-  *pFlashSR  = FLASH_PGERR;                              /* Reset Error Flags */
 
-  *pFlashCR  = (FLASH_CR_PER |                           /* Page Erase Enabled */
-                 (p <<  3)   |                           /* page Number. 0 to 127 for each bank */
-                 (b << 11)    );
-  *pFlashCR |=  FLASH_CR_STRT;                           /* Start Erase */
-  DSB();
+/*
+ *  Erase pending Sector range (collected by EraseSector)
+ *    Return Value:   0 - OK,  1 - Failed
+ *    Note:           At most FLASH_ERASE_DEFER - 1 pages are pending. The erases
+ *                    of one call are bounded by FLASH_TO_FLUSH, a call that would
+ *                    exceed the host timeout fails instead.
+ */
+
+#if defined FLASH_MEM
+static int EraseFlush (void)
+{
+  u32 adr   = gEraseStart;
+  u32 end   = gEraseEnd;
+  u32 start = TimerGet();
+  u32 limit = FLASH_TO_FLUSH * gFlashTiming.clkKHz;
 
-  while (*pFlashSR & FLASH_SR_BSY) NOP();                /* Wait until operation is finished */
+  gEraseStart = gEraseEnd = 0U;
 
-  if (*pFlashSR & FLASH_PGERR) {                         /* Check for Error */
-    *pFlashSR  = FLASH_PGERR;                            /* Reset Error Flags */
-    return (1);                                          /* Failed */
+  for (; adr < end; adr += (1UL << gFlash.pageShift)) {
+    if ((TimerGet() - start) > limit) {
+      gFlashTiming.timeouts++;
+      return (1);                                        /* Timeout */
+    }
+    if (ErasePage(adr) != 0) {
+      return (1);                                        /* Failed */
+    }
   }
 
   return (0);                                            /* Done */
 }
 #endif /* FLASH_MEM */
 
+
+/*
+ *  Erase Sector in Flash Memory
+ *    Parameter:      adr:  Sector Address
+ *    Return Value:   0 - OK,  1 - Failed
+ *    Note:           Consecutive sectors starting at a bank start are collected,
+ *                    a complete bank is mass erased (MER1/MER2). Sectors that do
+ *                    not complete a bank are page erased by the next operation.
+ *                    Banks with more than FLASH_ERASE_DEFER pages are page erased
+ *                    right away.
+ */
+
+#if defined FLASH_MEM
+int EraseSector (unsigned long adr)
+{
+  u32 bankMsk = gFlash.bankSize - 1U;
+  u32 cr;
+
+  if ((adr != gEraseEnd) || (gEraseStart == gEraseEnd)) {
+    if (EraseFlush() != 0) {                             /* Not consecutive: erase pending sectors */
+      return (1);                                        /* Failed */
+    }
+    if ((((adr - gFlash.base) & bankMsk) != 0U) ||      /* Cannot complete a bank */
+        ((gFlash.bankSize >> gFlash.pageShift) > FLASH_ERASE_DEFER)) {
+      return (ErasePage(adr));                           /* Erase now */
+    }
+    gEraseStart = adr;
+  }
+  gEraseEnd = adr + (1UL << gFlash.pageShift);
+
+  if (((gEraseEnd - gFlash.base) & bankMsk) == 0U)
+  {                                                      /* Complete bank collected */
+    if (gFlash.dualBank == 0U) {
+      cr = (FLASH_CR_MER1 | FLASH_CR_MER2);              /* Single-Bank mass erase needs MER1 and MER2 */
+    } else {
+      cr = (GetFlashBankNum(gEraseStart) == 0U) ? FLASH_CR_MER1 : FLASH_CR_MER2;
+    }
+    gEraseStart = gEraseEnd = 0U;
+
+    return (EraseExec(cr));                              /* Bank mass erase */
+  }
+
+  return (0);                                            /* Done (or pending) */
+}
+#endif /* FLASH_MEM */
+
 #if defined FLASH_OPT
 int EraseSector (unsigned long adr) {
   /* erase sector is not needed for Flash Option bytes */
@@ -571,6 +1217,123 @@ int EraseSector (unsigned long adr) {
 #endif /* FLASH_OPT */
 
 
+/*
+ *  Check if Data equals 'Initial Content of Erased Memory'
+ *    Parameter:      buf:  Data
+ *                    sz:   Size (in bytes, multiple of 4)
+ *    Return Value:   1 - all bytes 0xFF,  0 - otherwise
+ */
+
+#if defined FLASH_MEM
+static u32 IsErasedPattern (unsigned char *buf, u32 sz)
+{
+  const u32 *w;
+  u32 val = 0xFFFFFFFF;
+
+  if (((u32)buf & 3U) == 0U)
+  {                                                      /* Word aligned buffer */
+    for (w = (const u32 *)buf; sz != 0U; sz -= 4U) {
+      val &= *w++;
+    }
+  }
+  else
+  {
+    for (; sz != 0U; sz--) {
+      val &= (u32)*buf++ | 0xFFFFFF00;
+    }
+  }
+
+  return ((val == 0xFFFFFFFF) ? 1U : 0U);
+}
+#endif /* FLASH_MEM */
+
+
+/*
+ *  Program Quad-Word in Flash Memory
+ *    Parameter:      adr:  Quad-Word Address (16 byte aligned)
+ *                    buf:  Quad-Word Data
+ *    Return Value:   0 - OK,  1 - Failed
+ */
+
+#if defined FLASH_MEM
+static int ProgramQuadWord (unsigned long adr, unsigned char *buf)
+{
+  u32 start;
+
+  *gFlash.pCR = FLASH_CR_PG;                             /* Programming Enabled */
+
+  start = TimerGet();
+
+  M32(adr    ) = (u32)((*(buf+ 0)      ) |
+                       (*(buf+ 1) <<  8) |
+                       (*(buf+ 2) << 16) |
+                       (*(buf+ 3) << 24) );              /* Program the 1st word of the quad-word */
+  M32(adr + 4) = (u32)((*(buf+ 4)      ) |
+                       (*(buf+ 5) <<  8) |
+                       (*(buf+ 6) << 16) |
+                       (*(buf+ 7) << 24) );              /* Program the 2nd word of the quad-word */
+  M32(adr + 8) = (u32)((*(buf+ 8)      ) |
+                       (*(buf+ 9) <<  8) |
+                       (*(buf+10) << 16) |
+                       (*(buf+11) << 24) );              /* Program the 3rd word of the quad-word */
+  M32(adr +12) = (u32)((*(buf+12)      ) |
+                       (*(buf+13) <<  8) |
+                       (*(buf+14) << 16) |
+                       (*(buf+15) << 24) );              /* Program the 4th word of the quad-word */
+  DSB();
+
+  if (WaitBusy(gFlash.pSR, start, FLASH_TO_PROG)) {      /* Wait until operation is finished */
+    return (1);                                          /* Timeout */
+  }
+  TimingAdd(&gFlashTiming.prog, start);
+
+  if (*gFlash.pSR & FLASH_PGERR) {                       /* Check for Error */
+    *gFlash.pSR  = FLASH_PGERR;                          /* Reset Error Flags */
+    return (1);                                          /* Failed */
+  }
+
+  return (0);
+}
+#endif /* FLASH_MEM */
+
+
+/*
+ *  Program Burst (8 Quad-Words) in Flash Memory
+ *    Parameter:      adr:  Burst Address (128 byte aligned)
+ *                    buf:  Burst Data (word aligned)
+ *    Return Value:   0 - OK,  1 - Failed
+ */
+
+#if defined FLASH_MEM
+static int ProgramBurst (unsigned long adr, unsigned char *buf)
+{
+  const u32 *src = (const u32 *)buf;                     /* buf is word aligned */
+  vu32      *dst = (vu32 *)adr;                          /* adr is burst aligned */
+  u32        n, start;
+
+  *gFlash.pCR = (FLASH_CR_PG | FLASH_CR_BWR);            /* Burst Programming Enabled */
+
+  start = TimerGet();
+  for (n = (FLASH_BURST_SIZE >> 2); n != 0U; n--) {      /* Program 8 quad-words in one go */
+    *dst++ = *src++;
+  }
+  DSB();
+
+  if (WaitBusy(gFlash.pSR, start, FLASH_TO_PROG)) {      /* Wait until operation is finished */
+    return (1);                                          /* Timeout */
+  }
+  TimingAdd(&gFlashTiming.prog, start);
+
+  if (*gFlash.pSR & FLASH_PGERR) {                       /* Check for Error */
+    *gFlash.pSR  = FLASH_PGERR;                          /* Reset Error Flags */
+    return (1);                                          /* Failed */
+  }
+
+  return (0);
+}
+#endif /* FLASH_MEM */
+
+
 /*
  *  Program Page in Flash Memory
  *    Parameter:      adr:  Page Start Address
@@ -582,55 +1345,55 @@ int EraseSector (unsigned long adr) {
 #if defined FLASH_MEM
 int ProgramPage (unsigned long adr, unsigned long sz, unsigned char *buf)
 {
+  int rc = 0;
 
   sz = (sz + 15) & ~15U;                                 /* Adjust size for four words */
 
-  while (*pFlashSR & FLASH_SR_BSY) NOP();                /* Wait until operation is finished */
+  if (EraseFlush() != 0) {                               /* Erase pending sectors */
+    return (1);                                          /* Failed */
+  }
 
-  *pFlashSR = FLASH_PGERR;                               /* Reset Error Flags */
+  if (WaitBusy(gFlash.pSR, TimerGet(), FLASH_TO_IDLE)) { /* Wait until operation is finished */
+    return (1);                                          /* Failed */
+  }
 
-  *pFlashCR = FLASH_CR_PG ;	                             /* Programming Enabled */
+  *gFlash.pSR = FLASH_PGERR;                             /* Reset Error Flags */
 
   while (sz)
   {
-//    M32(adr    ) = *((u32 *)(buf + 0));                  /* Program the 1st word of the quad-word */
-//    M32(adr + 4) = *((u32 *)(buf + 4));                  /* Program the 2nd word of the quad-word */
-//    M32(adr + 8) = *((u32 *)(buf + 8));                  /* Program the 3rd word of the quad-word */
-//    M32(adr +12) = *((u32 *)(buf +12));                  /* Program the 4th word of the quad-word */
-
-    M32(adr    ) = (u32)((*(buf+ 0)      ) |
-                         (*(buf+ 1) <<  8) |
-                         (*(buf+ 2) << 16) |
-                         (*(buf+ 3) << 24) );            /* Program the 1st word of the quad-word */
-    M32(adr + 4) = (u32)((*(buf+ 4)      ) |
-                         (*(buf+ 5) <<  8) |
-                         (*(buf+ 6) << 16) |
-                         (*(buf+ 7) << 24) );            /* Program the 2nd word of the quad-word */
-    M32(adr + 8) = (u32)((*(buf+ 8)      ) |
-                         (*(buf+ 9) <<  8) |
-                         (*(buf+10) << 16) |
-                         (*(buf+11) << 24) );            /* Program the 3rd word of the quad-word */
-    M32(adr +12) = (u32)((*(buf+12)      ) |
-                         (*(buf+13) <<  8) |
-                         (*(buf+14) << 16) |
-                         (*(buf+15) << 24) );            /* Program the 4th word of the quad-word */
-    DSB();
-
-    while (*pFlashSR & FLASH_SR_BSY) NOP();              /* Wait until operation is finished */
+    if (((adr & (FLASH_BURST_SIZE - 1U)) == 0U) &&
+        (((u32)buf & 3U) == 0U)                 &&
+        (sz >= FLASH_BURST_SIZE)                  )
+    {                                                    /* Burst aligned destination, word aligned source */
+      if (IsErasedPattern(buf, FLASH_BURST_SIZE) == 0U) {  /* Erased burst stays untouched */
+        rc = ProgramBurst(adr, buf);
+        if (rc != 0) {
+          break;                                         /* Failed */
+        }
+      }
 
-    if (*pFlashSR & FLASH_PGERR) {                       /* Check for Error */
-      *pFlashSR  = FLASH_PGERR;                          /* Reset Error Flags */
-      return (1);                                        /* Failed */
+      adr += FLASH_BURST_SIZE;                           /* Next burst */
+      buf += FLASH_BURST_SIZE;
+      sz  -= FLASH_BURST_SIZE;
     }
+    else
+    {                                                    /* Unaligned head, tail or buffer */
+      if (IsErasedPattern(buf, FLASH_QUADWORD_SIZE) == 0U) { /* Erased quad-word stays untouched */
+        rc = ProgramQuadWord(adr, buf);
+        if (rc != 0) {
+          break;                                         /* Failed */
+        }
+      }
 
-    adr += 16;                                           /* Next quad-word */
-    buf += 16;
-    sz  -= 16;
+      adr += FLASH_QUADWORD_SIZE;                        /* Next quad-word */
+      buf += FLASH_QUADWORD_SIZE;
+      sz  -= FLASH_QUADWORD_SIZE;
+    }
   }
 
-  *pFlashCR = 0U;                                       /* Reset CR */
+  *gFlash.pCR = 0U;                                      /* Reset CR */
 
-  return (0);
+  return (rc);
 }
 #endif /* FLASH_MEM */
 
@@ -638,11 +1401,34 @@ int ProgramPage (unsigned long adr, unsigned long sz, unsigned char *buf)
 #ifdef FLASH_OPT
 int ProgramPage (unsigned long adr, unsigned long sz, unsigned char *buf)
 {
-  (void)adr;
-  (void)sz;
+  vu32 *reg;
+  u32   idx, val;
 
-  /* not yet coded */
-  return (0);                                            /* Done */
+  for (; sz >= 4U; adr += 4, buf += 4, sz -= 4) {
+    idx = (adr - gOptBase) >> 2;
+    if (idx >= FLASH_OPT_NUM) {
+      return (1);                                        /* Outside option bytes image */
+    }
+
+    val = (u32)((*(buf+ 0)      ) |
+                (*(buf+ 1) <<  8) |
+                (*(buf+ 2) << 16) |
+                (*(buf+ 3) << 24) );
+
+#ifndef FLASH_OPT_RDP_LEVEL2
+    if ((idx == 0U) && ((val & FLASH_OPTR_RDP) == FLASH_OPTR_RDP_LEVEL2)) {
+      return (1);                                        /* RDP Level 2 is irreversible, not allowed */
+    }
+#endif
+
+    reg = &FLASH->OPTR + idx;
+    if (((*reg ^ val) & gOptMask[idx]) != 0U) {          /* Stage changed register only */
+      *reg = (*reg & ~gOptMask[idx]) | (val & gOptMask[idx]);
+      gOptChanged = 1U;
+    }
+  }
+
+  return (0);                                            /* Done (OPTSTRT in UnInit) */
 }
 #endif /* FLASH_OPT */
 
@@ -655,13 +1441,67 @@ int ProgramPage (unsigned long adr, unsigned long sz, unsigned char *buf)
  *    Return Value:   (adr+sz) - OK, Failed Address
  */
 
+#if defined FLASH_MEM
+unsigned long Verify (unsigned long adr, unsigned long sz, unsigned char *buf)
+{
+  const vu32 *p;
+  const u32  *b;
+  u32 end = adr + sz;
+
+  if (EraseFlush() != 0) {                               /* Erase pending sectors */
+    return (adr);                                        /* Failed */
+  }
+
+  if (((adr | (u32)buf) & 3U) == 0U)
+  {                                                      /* Word aligned Flash and buffer */
+    p = (const vu32 *)adr;
+    b = (const u32  *)buf;
+
+    while ((end - adr) >= FLASH_QUADWORD_SIZE) {
+      if (((p[0] ^ b[0]) | (p[1] ^ b[1]) |
+           (p[2] ^ b[2]) | (p[3] ^ b[3])  ) != 0U) {     /* Compare complete quad-word */
+        break;                                           /* Mismatch, locate failing byte */
+      }
+      p   += 4;                                          /* Next quad-word */
+      b   += 4;
+      adr += FLASH_QUADWORD_SIZE;
+      buf += FLASH_QUADWORD_SIZE;
+    }
+  }
+
+  while (adr < end) {                                    /* Compare remaining bytes */
+    if (M8(adr) != *buf) {
+      return (adr);                                      /* Failed Address */
+    }
+    adr++;
+    buf++;
+  }
+
+  return (end);                                          /* Done */
+}
+#endif /* FLASH_MEM */
+
 #ifdef FLASH_OPT
 unsigned long Verify (unsigned long adr, unsigned long sz, unsigned char *buf)
 {
-  (void)adr;
-  (void)sz;
+  u32 idx, val;
+
+  for (; sz >= 4U; adr += 4, buf += 4, sz -= 4) {
+    idx = (adr - gOptBase) >> 2;
+    if (idx >= FLASH_OPT_NUM) {
+      return (adr);                                      /* Outside option bytes image */
+    }
+
+    val = (u32)((*(buf+ 0)      ) |
+                (*(buf+ 1) <<  8) |
+                (*(buf+ 2) << 16) |
+                (*(buf+ 3) << 24) );
+
+    if (((*(&FLASH->OPTR + idx) ^ val) & gOptMask[idx]) != 0U) {
+      return (adr);                                      /* Failed Address */
+    }
+  }
 
-  /* not yet coded */
   return (adr + sz);
 }
 #endif /* FLASH_OPT */